@@ -0,0 +1,139 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// source tree or at
+// <https://github.com/Krzmbrzl/NamedPipe/blob/main/LICENSE>.
+
+// Compares the message throughput of the static NamedPipe::write (which opens and closes the pipe for every message)
+// against a PipeWriter that keeps its connection open. Framed messages are additionally sent one by one via
+// PipeWriter::write_message, in batches via PipeWriter::write_many and through a CoalescingWriter.
+//
+// Usage: write_throughput [messageCount] [messageSize] [batchSize]
+
+#include <npipe/CoalescingWriter.hpp>
+#include <npipe/ConstBuffer.hpp>
+#include <npipe/Exception.hpp>
+#include <npipe/Framing.hpp>
+#include <npipe/InterruptException.hpp>
+#include <npipe/NamedPipe.hpp>
+#include <npipe/PipeWriter.hpp>
+#include <npipe/TimeoutException.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+constexpr const char *benchmarkPipeName = "writeThroughputPipe";
+
+struct Result {
+	double seconds;
+	std::size_t failedAttempts;
+};
+
+template< typename WriteFunc >
+Result run(std::atomic_size_t &receivedBytes, std::size_t callCount, std::size_t bytesPerCall, WriteFunc writeFunc) {
+	const std::size_t expectedBytes = receivedBytes.load() + callCount * bytesPerCall;
+	std::size_t failedAttempts      = 0;
+
+	const auto start = std::chrono::steady_clock::now();
+
+	for (std::size_t i = 0; i < callCount; ++i) {
+		while (true) {
+			try {
+				writeFunc();
+				break;
+			} catch (const npipe::Exception &) {
+				// Most likely the pipe was full -> try again
+				++failedAttempts;
+			}
+		}
+	}
+
+	// Wait for the reader to have received everything
+	while (receivedBytes.load() < expectedBytes) {
+		std::this_thread::yield();
+	}
+
+	const auto end = std::chrono::steady_clock::now();
+
+	return { std::chrono::duration< double >(end - start).count(), failedAttempts };
+}
+
+void report(const std::string &name, const Result &result, std::size_t messageCount) {
+	std::cout << name << ": " << static_cast< std::size_t >(static_cast< double >(messageCount) / result.seconds) << " messages/s ("
+			  << result.seconds << " s total, " << result.failedAttempts << " failed attempts)" << std::endl;
+}
+
+int main(int argc, char **argv) {
+	const std::size_t messageCount = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 10000;
+	const std::size_t messageSize  = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 64;
+	const std::size_t batchSize    = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 64;
+
+	const std::vector< std::byte > message(messageSize, std::byte(42));
+
+	npipe::NamedPipe pipe = npipe::NamedPipe::create(benchmarkPipeName);
+
+	std::atomic_size_t receivedBytes = 0;
+	std::atomic_bool stop            = false;
+
+	std::thread reader([&]() {
+		try {
+			while (!stop) {
+				try {
+					receivedBytes += pipe.read_blocking(std::chrono::milliseconds(100)).size();
+				} catch (const npipe::TimeoutException &) {
+				}
+			}
+		} catch (const npipe::InterruptException &) {
+		}
+	});
+
+	std::cout << "Sending " << messageCount << " messages of " << messageSize << " bytes each" << std::endl;
+
+	report("NamedPipe::write (static)",
+		   run(receivedBytes, messageCount, message.size(),
+			   [&]() {
+				   npipe::NamedPipe::write(benchmarkPipeName, message.data(), message.size(), std::chrono::seconds(1));
+			   }),
+		   messageCount);
+
+	npipe::PipeWriter writer(benchmarkPipeName);
+	report("PipeWriter::write",
+		   run(receivedBytes, messageCount, message.size(),
+			   [&]() { writer.write(message.data(), message.size(), std::chrono::seconds(1)); }),
+		   messageCount);
+
+	const std::size_t frameSize = npipe::FrameHeader::size + message.size();
+	report("PipeWriter::write_message",
+		   run(receivedBytes, messageCount, frameSize,
+			   [&]() { writer.write_message(message.data(), message.size(), std::chrono::seconds(1)); }),
+		   messageCount);
+
+	const std::vector< npipe::ConstBuffer > batch(batchSize, { message.data(), message.size() });
+	report("PipeWriter::write_many (batches of " + std::to_string(batchSize) + ")",
+		   run(receivedBytes, messageCount / batchSize, batchSize * frameSize,
+			   [&]() {
+				   std::size_t written = 0;
+				   while (written < batch.size()) {
+					   written += writer.write_many(batch.data() + written, batch.size() - written,
+													std::chrono::seconds(1));
+				   }
+			   }),
+		   messageCount / batchSize * batchSize);
+
+	{
+		npipe::CoalescingWriter coalescingWriter(benchmarkPipeName);
+		report("CoalescingWriter::write",
+			   run(receivedBytes, messageCount, frameSize,
+				   [&]() { coalescingWriter.write(message.data(), message.size(), std::chrono::seconds(1)); }),
+			   messageCount);
+	}
+
+	stop = true;
+	pipe.interrupt();
+	reader.join();
+}
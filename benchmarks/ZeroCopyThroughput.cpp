@@ -0,0 +1,110 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// source tree or at
+// <https://github.com/Krzmbrzl/NamedPipe/blob/main/LICENSE>.
+
+// Compares the data throughput of PipeWriter::write (which copies the payload into the pipe) against
+// PipeWriter::write_zero_copy (which maps the payload's pages into the pipe on Linux) for large payloads.
+// Zero-copy writes need fresh memory for every payload, so unless the payload would have to be produced in freshly
+// allocated memory anyway, mapping and faulting in those pages can easily cost more than the copy they save.
+//
+// Usage: zero_copy_throughput [payloadCount] [payloadSize]
+
+#include <npipe/InterruptException.hpp>
+#include <npipe/NamedPipe.hpp>
+#include <npipe/PageAlignedBuffer.hpp>
+#include <npipe/PipeWriter.hpp>
+#include <npipe/TimeoutException.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+constexpr const char *benchmarkPipeName = "zeroCopyThroughputPipe";
+
+template< typename WriteFunc >
+double run(std::atomic_size_t &receivedBytes, std::size_t payloadCount, std::size_t payloadSize, WriteFunc writeFunc) {
+	const std::size_t expectedBytes = receivedBytes.load() + payloadCount * payloadSize;
+
+	const auto start = std::chrono::steady_clock::now();
+
+	for (std::size_t i = 0; i < payloadCount; ++i) {
+		writeFunc();
+	}
+
+	// Wait for the reader to have received everything
+	while (receivedBytes.load() < expectedBytes) {
+		std::this_thread::yield();
+	}
+
+	const auto end = std::chrono::steady_clock::now();
+
+	return std::chrono::duration< double >(end - start).count();
+}
+
+void report(const std::string &name, double seconds, std::size_t payloadCount, std::size_t payloadSize) {
+	const double gigabytes = static_cast< double >(payloadCount * payloadSize) / (1024.0 * 1024.0 * 1024.0);
+
+	std::cout << name << ": " << gigabytes / seconds << " GB/s (" << seconds << " s total)" << std::endl;
+}
+
+int main(int argc, char **argv) {
+	const std::size_t payloadCount = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 200;
+	const std::size_t payloadSize  = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 4 * 1024 * 1024;
+
+	npipe::NamedPipe pipe = npipe::NamedPipe::create(benchmarkPipeName);
+
+	std::atomic_size_t receivedBytes = 0;
+	std::atomic_bool stop            = false;
+
+	std::thread reader([&]() {
+		std::vector< std::byte > buffer(1024 * 1024);
+
+		try {
+			while (!stop) {
+				try {
+					receivedBytes += pipe.read_into(buffer.data(), buffer.size(), std::chrono::milliseconds(100));
+				} catch (const npipe::TimeoutException &) {
+				}
+			}
+		} catch (const npipe::InterruptException &) {
+		}
+	});
+
+	std::cout << "Sending " << payloadCount << " payloads of " << payloadSize << " bytes each" << std::endl;
+
+	npipe::PipeWriter writer(benchmarkPipeName);
+
+	// Both variants produce every payload from scratch, as a real sender would. The copy path can reuse its buffer
+	// for that, whereas every zero-copy write gives up its buffer, so each payload needs freshly mapped memory.
+	// That cost is inherent to zero-copy writes and thus part of the measurement.
+	std::vector< std::byte > payload(payloadSize);
+	report("PipeWriter::write",
+		   run(receivedBytes, payloadCount, payloadSize,
+			   [&]() {
+				   std::fill(payload.begin(), payload.end(), std::byte(42));
+
+				   writer.write(payload.data(), payload.size(), std::chrono::seconds(5));
+			   }),
+		   payloadCount, payloadSize);
+
+	report("PipeWriter::write_zero_copy",
+		   run(receivedBytes, payloadCount, payloadSize,
+			   [&]() {
+				   npipe::PageAlignedBuffer buffer(payloadSize);
+				   std::fill(buffer.begin(), buffer.end(), std::byte(42));
+
+				   writer.write_zero_copy(std::move(buffer), std::chrono::seconds(5));
+			   }),
+		   payloadCount, payloadSize);
+
+	stop = true;
+	pipe.interrupt();
+	reader.join();
+}
@@ -0,0 +1,164 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// source tree or at
+// <https://github.com/Krzmbrzl/NamedPipe/blob/main/LICENSE>.
+
+#pragma once
+
+#include "npipe/PipeWriter.hpp"
+#include "npipe/Result.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <filesystem>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace npipe {
+
+template< typename value_t > class MpscRing;
+
+/**
+ * Settings for an AsyncWriter
+ */
+struct AsyncWriterOptions {
+	/**
+	 * The maximum amount of writes that can be queued (rounded up to the next power of two). Once the queue is full,
+	 * further writes are rejected right away.
+	 */
+	std::size_t capacity = 1024;
+	/**
+	 * Whether messages are written in framed mode (see NamedPipe::write_message). A frame of which only the
+	 * beginning could be written is finished as in PipeWriter::write_message, so the reported amount of bytes is
+	 * either zero or the size of the message. In unframed mode, a connection through which only part of a message
+	 * has been written is closed, so that the next message doesn't continue where the torn one has stopped.
+	 */
+	bool framed = false;
+	/**
+	 * How long the connection to a pipe is kept open while nothing is written to it
+	 */
+	std::chrono::milliseconds idleTimeout = std::chrono::seconds(5);
+};
+
+/**
+ * Writer that performs writes on a background thread, so that the threads producing the messages never have to
+ * wait for the pipe. Writes are handed to the background thread via a bounded lock-free queue and carried out in
+ * the order in which they have been queued. The outcome of every write is reported via a callback or a future.
+ *
+ * As opposed to CoalescingWriter, every write is carried out (and reported) on its own and the writes may target
+ * any amount of different pipes. As all pipes share the background thread, a pipe without a reader is not waited
+ * for: writes to it fail right away with Status::Closed, so that they don't hold up the writes to other pipes.
+ */
+class AsyncWriter {
+public:
+	/**
+	 * Function receiving the outcome of a write (see PipeWriter::try_write). It is invoked on the background thread
+	 * and must neither throw nor block for long, as it holds up the writes queued behind it.
+	 */
+	using completion_t = std::function< void(Result< std::size_t > result) >;
+
+	/**
+	 * @param options The settings to use
+	 */
+	explicit AsyncWriter(AsyncWriterOptions options = AsyncWriterOptions());
+	/**
+	 * Carries out all writes that have been queued so far (each one bounded by its timeout) and stops the background
+	 * thread
+	 */
+	~AsyncWriter();
+
+	AsyncWriter(const AsyncWriter &) = delete;
+	AsyncWriter &operator=(const AsyncWriter &) = delete;
+
+	/**
+	 * Queues a message for being written to the named pipe at the given location. The message is copied, so its
+	 * memory can be reused right away. This function is thread-safe and never waits for the background thread.
+	 *
+	 * @param pipePath The path at which the pipe is expected to exist
+	 * @param message A pointer to the beginning of the message that shall be sent
+	 * @param messageSize The size of the message to write
+	 * @param completion The function to report the outcome of the write to (may be empty)
+	 * @param timeout How long the write itself is allowed to take while the pipe is full. If the pipe has no reader
+	 * at the time the write is carried out, the write fails right away with Status::Closed.
+	 * @returns Whether the write has been queued. If the queue is full, the completion is not invoked.
+	 *
+	 * @throws FramingException If framed mode is used and the message is too big to be framed
+	 */
+	bool write_async(const std::filesystem::path &pipePath, const std::byte *message, std::size_t messageSize,
+					 completion_t completion, std::chrono::milliseconds timeout = std::chrono::milliseconds(10));
+
+	/**
+	 * Variant of write_async() that reports the outcome of the write via a future. If the queue is full, the future
+	 * is ready right away and holds Status::Timeout.
+	 *
+	 * @note Every future requires a memory allocation - use the callback variant if that is a concern
+	 */
+	[[nodiscard]] std::future< Result< std::size_t > >
+		write_async(const std::filesystem::path &pipePath, const std::byte *message, std::size_t messageSize,
+					std::chrono::milliseconds timeout = std::chrono::milliseconds(10));
+
+	/**
+	 * @returns The amount of writes that have been queued but not carried out yet
+	 */
+	[[nodiscard]] std::size_t pending() const noexcept;
+
+private:
+	struct Write;
+
+	AsyncWriterOptions m_options;
+
+	/**
+	 * The writes that haven't been carried out yet
+	 */
+	std::unique_ptr< MpscRing< Write > > m_ring;
+
+	std::atomic_bool m_stop = false;
+	std::atomic_bool m_idle = false;
+
+	std::mutex m_mutex;
+	/**
+	 * Wakes up the background thread
+	 */
+	std::condition_variable m_wakeup;
+
+	struct Connection {
+		PipeWriter writer;
+		std::chrono::steady_clock::time_point lastUsed;
+	};
+
+	/**
+	 * Connections to the pipes that have been written to recently. Only accessed by the background thread.
+	 */
+	std::map< std::filesystem::path, Connection > m_connections;
+	/**
+	 * The point in time at which the next connection becomes idle. Only accessed by the background thread.
+	 */
+	std::chrono::steady_clock::time_point m_nextEviction = std::chrono::steady_clock::time_point::max();
+
+	std::thread m_thread;
+
+	void wakeThread();
+	void runThread();
+	[[nodiscard]] bool hasWork() const noexcept;
+	/**
+	 * Carries out the write at the read position
+	 */
+	void process();
+	/**
+	 * Writes the given message to the given pipe, connecting to it first if necessary
+	 */
+	[[nodiscard]] Result< std::size_t > send(const std::filesystem::path &pipePath, const std::byte *message,
+											 std::size_t messageSize, std::chrono::milliseconds timeout);
+	/**
+	 * Closes the connections that haven't been used for the configured idle timeout
+	 */
+	void evictIdle();
+};
+
+} // namespace npipe
@@ -0,0 +1,129 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// source tree or at
+// <https://github.com/Krzmbrzl/NamedPipe/blob/main/LICENSE>.
+
+#pragma once
+
+#include "npipe/Result.hpp"
+#include "npipe/StopToken.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+#ifdef PIPE_PLATFORM_UNIX
+
+namespace npipe {
+
+class NamedPipe;
+class PipeWriter;
+class Reactor;
+
+/**
+ * Awaitable for reading from a pipe via co_await without blocking a thread (see NamedPipe::async_read). While
+ * waiting, the coroutine is suspended and a Reactor watches the pipe. The coroutine is resumed on the thread running
+ * that reactor.
+ *
+ * @note The library itself doesn't require C++20. await_suspend accepts any coroutine handle type, so that this class
+ * is usable from C++20 code without having to be compiled differently.
+ */
+class ReadAwaitable {
+public:
+	ReadAwaitable(const NamedPipe &pipe, Reactor &reactor, std::chrono::milliseconds timeout, StopToken stopToken);
+
+	/**
+	 * @returns Whether content is available right away, in which case the coroutine doesn't get suspended
+	 */
+	[[nodiscard]] bool await_ready() const noexcept;
+
+	template< typename handle_t > void await_suspend(handle_t handle) {
+		suspend([handle]() mutable { handle.resume(); });
+	}
+
+	/**
+	 * @returns All content that has been available in the pipe
+	 *
+	 * @throws TimeoutException If no content has become available in time
+	 * @throws InterruptException If the read has been cancelled
+	 * @throws PipeException If reading failed
+	 */
+	std::vector< std::byte > await_resume();
+
+private:
+	const NamedPipe &m_pipe;
+	Reactor &m_reactor;
+	std::chrono::milliseconds m_timeout;
+	StopToken m_stopToken;
+	Status m_status = Status::Ok;
+
+	void suspend(std::function< void() > resume);
+};
+
+/**
+ * Awaitable for writing to a pipe via co_await without blocking a thread (see PipeWriter::async_write). Whatever
+ * doesn't fit into the pipe right away is written once the pipe has room again, as reported by a Reactor. The
+ * coroutine is resumed on the thread running that reactor.
+ *
+ * @note The library itself doesn't require C++20. await_suspend accepts any coroutine handle type, so that this class
+ * is usable from C++20 code without having to be compiled differently.
+ */
+class WriteAwaitable {
+public:
+	WriteAwaitable(PipeWriter &writer, Reactor &reactor, const std::byte *message, std::size_t messageSize,
+				   std::chrono::milliseconds timeout, StopToken stopToken);
+
+	/**
+	 * Writes as much as possible right away
+	 *
+	 * @returns Whether the write is over already, in which case the coroutine doesn't get suspended
+	 */
+	[[nodiscard]] bool await_ready();
+
+	template< typename handle_t > void await_suspend(handle_t handle) {
+		suspend([handle]() mutable { handle.resume(); });
+	}
+
+	/**
+	 * @throws TimeoutException If the message couldn't be written completely in time
+	 * @throws InterruptException If the write has been cancelled
+	 * @throws PipeException If writing failed
+	 */
+	void await_resume() const;
+
+private:
+	using clock = std::chrono::steady_clock;
+
+	PipeWriter &m_writer;
+	Reactor &m_reactor;
+	const std::byte *m_message;
+	std::size_t m_messageSize;
+	std::size_t m_written = 0;
+	clock::time_point m_deadline;
+	StopToken m_stopToken;
+	Status m_status       = Status::Ok;
+	int m_errorCode       = 0;
+	bool m_waitForReader = false;
+	std::function< void() > m_resume;
+
+	void suspend(std::function< void() > resume);
+	/**
+	 * Writes as much as possible and starts waiting for the pipe if the message hasn't been written completely
+	 *
+	 * @returns Whether the write is over
+	 */
+	bool advance();
+	/**
+	 * Has the reactor report back once it is worth trying to continue the write
+	 */
+	void wait();
+	/**
+	 * Continues the write once the reactor reports back
+	 */
+	void onWatchCompleted(Status status);
+};
+
+} // namespace npipe
+
+#endif // PIPE_PLATFORM_UNIX
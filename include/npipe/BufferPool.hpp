@@ -0,0 +1,130 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// source tree or at
+// <https://github.com/Krzmbrzl/NamedPipe/blob/main/LICENSE>.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+namespace npipe {
+
+class BufferPool;
+
+/**
+ * A message whose memory has been borrowed from a BufferPool. Once the message is destroyed, its memory is handed
+ * back to the pool it came from, so that it can be reused for a later message.
+ *
+ * @note The pool a message has been taken from has to outlive the message
+ */
+class Message {
+public:
+	/**
+	 * Creates an empty message that isn't associated with any pool
+	 */
+	Message() noexcept = default;
+	~Message();
+
+	Message(const Message &) = delete;
+	Message &operator=(const Message &) = delete;
+
+	Message(Message &&other) noexcept;
+	Message &operator=(Message &&other) noexcept;
+
+	[[nodiscard]] std::byte *data() noexcept { return m_buffer; }
+	[[nodiscard]] const std::byte *data() const noexcept { return m_buffer; }
+
+	[[nodiscard]] std::byte *begin() noexcept { return m_buffer; }
+	[[nodiscard]] const std::byte *begin() const noexcept { return m_buffer; }
+	[[nodiscard]] std::byte *end() noexcept { return m_buffer + m_size; }
+	[[nodiscard]] const std::byte *end() const noexcept { return m_buffer + m_size; }
+
+	/**
+	 * @returns The size of the message in bytes
+	 */
+	[[nodiscard]] std::size_t size() const noexcept { return m_size; }
+
+	/**
+	 * @returns The size of the underlying buffer in bytes
+	 */
+	[[nodiscard]] std::size_t capacity() const noexcept { return m_capacity; }
+
+	[[nodiscard]] bool empty() const noexcept { return m_size == 0; }
+
+	/**
+	 * Changes the size of this message. If the current buffer is too small, a bigger one is taken from the pool and
+	 * the content is copied over. Newly added bytes are left uninitialized.
+	 *
+	 * @param size The new size
+	 */
+	void resize(std::size_t size);
+
+	/**
+	 * Hands the memory of this message back to its pool, leaving an empty message behind
+	 */
+	void release() noexcept;
+
+private:
+	friend class BufferPool;
+
+	Message(BufferPool *pool, std::byte *buffer, std::size_t size, std::size_t capacity) noexcept;
+
+	BufferPool *m_pool     = nullptr;
+	std::byte *m_buffer    = nullptr;
+	std::size_t m_size     = 0;
+	std::size_t m_capacity = 0;
+};
+
+/**
+ * A pool of reusable message buffers. Buffers are grouped in size classes (powers of two) and every size class keeps
+ * a bounded number of unused buffers around. In steady state, obtaining and returning a buffer therefore doesn't
+ * involve the allocator at all. All operations are lock-free, so a single pool can be shared by multiple threads.
+ */
+class BufferPool {
+public:
+	/**
+	 * The size of the smallest size class
+	 */
+	static constexpr std::size_t minBufferSize = 256;
+	/**
+	 * The size of the largest size class. Bigger buffers are allocated on demand and are not kept around.
+	 */
+	static constexpr std::size_t maxBufferSize = 16 * 1024 * 1024;
+
+	/**
+	 * @param buffersPerClass How many unused buffers are kept around per size class at most
+	 */
+	explicit BufferPool(std::size_t buffersPerClass = 16);
+	~BufferPool();
+
+	BufferPool(const BufferPool &) = delete;
+	BufferPool &operator=(const BufferPool &) = delete;
+
+	/**
+	 * @param size The requested size
+	 * @returns A message of the given size. Its content is uninitialized.
+	 */
+	[[nodiscard]] Message acquire(std::size_t size);
+
+private:
+	friend class Message;
+
+	/**
+	 * Takes back the given buffer
+	 */
+	void release(std::byte *buffer, std::size_t capacity) noexcept;
+
+	/**
+	 * The amount of unused buffers kept around per size class
+	 */
+	std::size_t m_buffersPerClass;
+	/**
+	 * Slots for unused buffers. Every size class owns m_buffersPerClass consecutive slots. An empty slot holds a
+	 * nullptr.
+	 */
+	std::unique_ptr< std::atomic< std::byte * >[] > m_slots;
+};
+
+} // namespace npipe
@@ -0,0 +1,162 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// source tree or at
+// <https://github.com/Krzmbrzl/NamedPipe/blob/main/LICENSE>.
+
+#pragma once
+
+#include "npipe/ConstBuffer.hpp"
+#include "npipe/PipeWriter.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace npipe {
+
+template< typename value_t > class MpscRing;
+
+/**
+ * Settings for a CoalescingWriter
+ */
+struct CoalescingWriterOptions {
+	/**
+	 * The amount of buffered bytes at which the buffered messages are written right away
+	 */
+	std::size_t flushThreshold = 16 * 1024;
+	/**
+	 * The maximum amount of time a message is held back in order to be written together with subsequent messages
+	 */
+	std::chrono::microseconds maxLatency = std::chrono::microseconds(50);
+	/**
+	 * The maximum amount of messages that can be buffered (rounded up to the next power of two). Once the buffer is
+	 * full, writers have to wait for the buffered messages to be written.
+	 */
+	std::size_t capacity = 1024;
+	/**
+	 * Whether messages are written in framed mode (see NamedPipe::write_message). Otherwise messages that are
+	 * written together end up as a single blob on the reading end.
+	 */
+	bool framed = true;
+	/**
+	 * How long a single attempt at writing the buffered messages may take (e.g. while there is no reader)
+	 */
+	std::chrono::milliseconds writeTimeout = std::chrono::milliseconds(100);
+};
+
+/**
+ * Writer that collects (small) messages from any amount of threads and writes them to the pipe in batches. Messages
+ * are handed to a background thread via a lock-free queue. That thread writes them once enough bytes have
+ * accumulated or once the oldest message has been held back for the configured maximum latency - whichever comes
+ * first. This drastically reduces the amount of system calls (and context switches) for chatty producers.
+ *
+ * Messages of a single thread are written in the order in which they have been passed to write(). If the pipe
+ * (temporarily) has no reader, messages are kept until they can be written.
+ */
+class CoalescingWriter {
+public:
+	/**
+	 * @param pipePath The path at which the pipe is expected to exist. It doesn't have to exist yet.
+	 * @param options The settings to use
+	 */
+	explicit CoalescingWriter(std::filesystem::path pipePath,
+							  CoalescingWriterOptions options = CoalescingWriterOptions());
+	/**
+	 * Makes a final attempt at writing all buffered messages (bounded by the configured write timeout) and stops the
+	 * background thread
+	 */
+	~CoalescingWriter();
+
+	CoalescingWriter(const CoalescingWriter &) = delete;
+	CoalescingWriter &operator=(const CoalescingWriter &) = delete;
+
+	/**
+	 * Hands a message over for being written. The message is copied, so its memory can be reused right away. This
+	 * function is thread-safe.
+	 *
+	 * @param message A pointer to the beginning of the message that shall be sent
+	 * @param messageSize The size of the message
+	 * @param timeout How long to wait for room in the buffer if it is full
+	 *
+	 * @throws TimeoutException If the buffer stayed full for the entire timeout
+	 * @throws FramingException If framed mode is used and the message is too big to be framed
+	 */
+	void write(const std::byte *message, std::size_t messageSize,
+			   std::chrono::milliseconds timeout = std::chrono::milliseconds(10));
+
+	/**
+	 * Writes all messages that have been handed over so far without waiting for the flush threshold or the maximum
+	 * latency and waits until they have been written. This function is thread-safe.
+	 *
+	 * @param timeout How long to wait for the messages to be written
+	 *
+	 * @throws TimeoutException If the messages couldn't be written in time
+	 */
+	void flush(std::chrono::milliseconds timeout = std::chrono::milliseconds(1000));
+
+	/**
+	 * @returns The path of the pipe this writer writes to
+	 */
+	[[nodiscard]] std::filesystem::path getPath() const noexcept;
+
+private:
+	CoalescingWriterOptions m_options;
+	PipeWriter m_writer;
+
+	/**
+	 * The messages that haven't been written yet
+	 */
+	std::unique_ptr< MpscRing< std::vector< std::byte > > > m_ring;
+	/**
+	 * The combined size of all messages that have been enqueued but not written yet
+	 */
+	std::atomic_size_t m_bufferedBytes = 0;
+	/**
+	 * The amount of bytes of the message at the read position that have been written already (unframed mode only).
+	 * Only accessed by the flusher.
+	 */
+	std::size_t m_headOffset = 0;
+
+	std::atomic_bool m_stop        = false;
+	std::atomic_bool m_idle        = false;
+	std::atomic_int m_flushRequests = 0;
+
+	std::mutex m_mutex;
+	/**
+	 * Wakes up the flusher
+	 */
+	std::condition_variable m_wakeup;
+	/**
+	 * Signals that messages have been written (and that there is room in the buffer again)
+	 */
+	std::condition_variable m_drained;
+
+	/**
+	 * Views of the messages that are about to be written (kept as a member to reuse its memory)
+	 */
+	std::vector< ConstBuffer > m_batch;
+
+	std::thread m_flusher;
+
+	void wakeFlusher();
+	void runFlusher();
+	/**
+	 * Writes the given amount of messages, starting at the read position
+	 *
+	 * @returns The amount of messages that have been written
+	 */
+	std::size_t writeBatch(std::size_t count);
+	/**
+	 * @param[out] bytes The combined size of all ready messages
+	 * @returns The amount of messages (starting at the read position) that are ready to be written
+	 */
+	std::size_t readyMessages(std::size_t &bytes) const noexcept;
+};
+
+} // namespace npipe
@@ -0,0 +1,20 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// source tree or at
+// <https://github.com/Krzmbrzl/NamedPipe/blob/main/LICENSE>.
+
+#pragma once
+
+#include <cstddef>
+
+namespace npipe {
+
+/**
+ * A non-owning view of a contiguous, read-only chunk of memory
+ */
+struct ConstBuffer {
+	const std::byte *data = nullptr;
+	std::size_t size      = 0;
+};
+
+} // namespace npipe
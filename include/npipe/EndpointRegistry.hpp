@@ -0,0 +1,149 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// source tree or at
+// <https://github.com/Krzmbrzl/NamedPipe/blob/main/LICENSE>.
+
+#pragma once
+
+#include "npipe/PipeWriter.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace npipe {
+
+/**
+ * Settings for an EndpointRegistry
+ */
+struct EndpointRegistryOptions {
+	/**
+	 * How long writes to an endpoint fail right away after the endpoint has been found to be unavailable. Once this
+	 * period is over, the next write tries to connect again (with its full timeout).
+	 */
+	std::chrono::milliseconds coolDown = std::chrono::seconds(1);
+	/**
+	 * How often unavailable endpoints are probed in the background. On Linux, endpoints are additionally probed
+	 * whenever a file of their name is created in (or moved into) their directories.
+	 */
+	std::chrono::milliseconds probeInterval = std::chrono::milliseconds(100);
+	/**
+	 * How long an endpoint may go without being written to before it is forgotten (closing its connection, if any).
+	 * A forgotten endpoint is treated like one that hasn't been written to yet.
+	 */
+	std::chrono::milliseconds evictAfter = std::chrono::minutes(1);
+};
+
+/**
+ * Writes to any amount of pipes, keeping a PipeWriter per pipe. Pipes that have been found to have no reader are
+ * remembered: Writes to them fail immediately with an EndpointUnavailableException instead of waiting for the full
+ * timeout. A background thread probes such pipes and switches them back to normal as soon as a reader shows up.
+ *
+ * All functions are thread-safe. Writes to the same pipe are serialized.
+ */
+class EndpointRegistry {
+public:
+	explicit EndpointRegistry(EndpointRegistryOptions options = EndpointRegistryOptions());
+	~EndpointRegistry();
+
+	EndpointRegistry(const EndpointRegistry &) = delete;
+	EndpointRegistry &operator=(const EndpointRegistry &) = delete;
+
+	/**
+	 * Writes a message to the pipe at the given location
+	 *
+	 * @param pipePath The path of the pipe
+	 * @param message A pointer to the beginning of the message that shall be sent
+	 * @param messageSize The size of the message
+	 * @param timeout How long this function is allowed to take
+	 *
+	 * @throws EndpointUnavailableException If the pipe is known to have no reader
+	 * @throws TimeoutException If the pipe couldn't be written to in time. If that's because the pipe couldn't be
+	 * connected to, it is considered unavailable from then on.
+	 *
+	 * @see PipeWriter::write
+	 */
+	void write(const std::filesystem::path &pipePath, const std::byte *message, std::size_t messageSize,
+			   std::chrono::milliseconds timeout = std::chrono::milliseconds(10));
+
+	/**
+	 * Writes a framed message to the pipe at the given location. The remarks from write() apply.
+	 *
+	 * @see PipeWriter::write_message
+	 */
+	void write_message(const std::filesystem::path &pipePath, const std::byte *message, std::size_t messageSize,
+					   std::chrono::milliseconds timeout = std::chrono::milliseconds(10));
+
+	/**
+	 * @returns Whether writes to the given pipe are attempted (i.e. whether it isn't known to have no reader)
+	 */
+	[[nodiscard]] bool isAvailable(const std::filesystem::path &pipePath) const;
+
+	/**
+	 * @returns The amount of endpoints that are currently being kept track of
+	 */
+	[[nodiscard]] std::size_t size() const;
+
+private:
+	struct Endpoint;
+
+	EndpointRegistryOptions m_options;
+
+	mutable std::mutex m_mutex;
+	/**
+	 * All endpoints that have been written to recently. Entries are shared with ongoing writes, so that they can be
+	 * evicted at any time.
+	 */
+	std::map< std::filesystem::path, std::shared_ptr< Endpoint > > m_endpoints;
+
+	std::atomic_bool m_stop = false;
+	std::condition_variable m_stopped;
+#ifdef __linux__
+	/**
+	 * inotify instance watching the directories of all endpoints that have become unavailable
+	 */
+	int m_watchHandle = -1;
+	/**
+	 * eventfd used to wake up the prober when stopping
+	 */
+	int m_stopHandle = -1;
+	/**
+	 * The point in time at which all unavailable endpoints are probed next. Only accessed by the prober.
+	 */
+	std::chrono::steady_clock::time_point m_nextFullProbe = std::chrono::steady_clock::now();
+#endif
+
+	std::thread m_prober;
+
+	std::shared_ptr< Endpoint > lookup(const std::filesystem::path &pipePath);
+	template< typename operation_t > void access(const std::filesystem::path &pipePath, operation_t &&operation);
+	/**
+	 * Makes sure the prober gets notified once the given endpoint's pipe shows up
+	 */
+	void watch(Endpoint &endpoint);
+	void markUnavailable(Endpoint &endpoint);
+	/**
+	 * Forgets the endpoints that haven't been written to for too long. The caller has to hold m_mutex.
+	 */
+	void evictIdle();
+	void runProber();
+	/**
+	 * Blocks until the next probe is due
+	 *
+	 * @param[out] changed The endpoints (identified by watch descriptor and file name) whose pipes have shown up
+	 * @param[out] lost The watch descriptors that have become invalid (e.g. because their directory got deleted)
+	 * @returns Whether all unavailable endpoints are due to be probed. Otherwise only the changed ones are.
+	 */
+	bool waitForProbe(std::vector< std::pair< int, std::string > > &changed, std::vector< int > &lost);
+};
+
+} // namespace npipe
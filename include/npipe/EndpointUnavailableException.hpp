@@ -0,0 +1,20 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// source tree or at
+// <https://github.com/Krzmbrzl/NamedPipe/blob/main/LICENSE>.
+
+#pragma once
+
+#include "npipe/TimeoutException.hpp"
+
+namespace npipe {
+/**
+ * An exception thrown instead of waiting for a pipe that has recently been found to have no reader (see
+ * EndpointRegistry). It derives from TimeoutException, as that is what waiting would have ended in.
+ */
+class EndpointUnavailableException : public TimeoutException {
+public:
+	const char *what() const noexcept { return "EndpointUnavailableException"; }
+};
+
+} // namespace npipe
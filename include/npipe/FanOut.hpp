@@ -0,0 +1,141 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// source tree or at
+// <https://github.com/Krzmbrzl/NamedPipe/blob/main/LICENSE>.
+
+#pragma once
+
+#include "npipe/NamedPipe.hpp"
+#include "npipe/StopToken.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <filesystem>
+#include <limits>
+#include <vector>
+
+namespace npipe {
+
+/**
+ * Settings for a FanOut
+ */
+struct FanOutOptions {
+	/**
+	 * The maximum amount of bytes that may be buffered for a destination that doesn't keep up with the others
+	 */
+	std::size_t maxBacklog = 1024 * 1024;
+	/**
+	 * Whether a destination whose backlog is full gets dropped if it doesn't catch up within slowConsumerTimeout.
+	 * Otherwise the fan-out waits for it to catch up for as long as it takes, which in turn stalls the source (and
+	 * thereby all other destinations).
+	 */
+	bool dropSlowConsumers = false;
+	/**
+	 * How long to wait for a destination with a full backlog before dropping it (see dropSlowConsumers)
+	 */
+	std::chrono::milliseconds slowConsumerTimeout = std::chrono::milliseconds(100);
+};
+
+/**
+ * Duplicates everything that arrives in a source pipe into several destination pipes. On Linux, the content is
+ * duplicated via tee() by referencing the source's pages instead of copying them. Only the part of the content that
+ * a destination can't take right away is copied into a per-destination backlog.
+ *
+ * Destinations are connected to as soon as they have a reader. Content that arrives while a destination has no
+ * reader is not delivered to it.
+ *
+ * @note On Windows the content is read via NamedPipe::read_blocking and written to every destination separately.
+ * There is no backlog, so a destination that can't take the content in time is either dropped or causes a
+ * TimeoutException.
+ */
+class FanOut {
+public:
+	/**
+	 * @param source The pipe to read from. It has to outlive this object.
+	 * @param destinations The paths of the pipes to duplicate the content into
+	 * @param options The settings to use
+	 */
+	FanOut(const NamedPipe &source, std::vector< std::filesystem::path > destinations,
+		   FanOutOptions options = FanOutOptions());
+	~FanOut();
+
+	FanOut(const FanOut &) = delete;
+	FanOut &operator=(const FanOut &) = delete;
+
+	/**
+	 * Waits for content to arrive in the source pipe and forwards all of it (up to the capacity of a pipe) to the
+	 * destinations. Call this in a loop to keep forwarding.
+	 *
+	 * @param timeout How long this function may wait for content (or for a slow destination to catch up). The
+	 * remarks from NamedPipe::read_blocking apply.
+	 * @param stopToken A token via which forwarding can be cancelled (causing an InterruptException)
+	 * @returns The amount of bytes that have been taken from the source pipe
+	 *
+	 * @throws TimeoutException If no content has arrived in time (or a slow destination didn't catch up in time)
+	 * @throws InterruptException If forwarding has been cancelled or the source pipe got interrupted
+	 */
+	std::size_t forward(std::chrono::milliseconds timeout = std::chrono::milliseconds{
+							(std::numeric_limits< unsigned int >::max)() },
+						const StopToken &stopToken = StopToken());
+
+	/**
+	 * @returns The amount of destinations
+	 */
+	[[nodiscard]] std::size_t destinationCount() const noexcept;
+
+	/**
+	 * @param index The index of the destination in the list passed to the constructor
+	 * @returns Whether the given destination has been dropped for being too slow
+	 */
+	[[nodiscard]] bool isDropped(std::size_t index) const noexcept;
+
+	/**
+	 * @param index The index of the destination in the list passed to the constructor
+	 * @returns The amount of bytes that are currently buffered for the given destination
+	 */
+	[[nodiscard]] std::size_t backlogSize(std::size_t index) const noexcept;
+
+private:
+	struct Destination {
+		std::filesystem::path path;
+		/**
+		 * Content that has been taken from the source but not yet been written to this destination
+		 */
+		std::vector< std::byte > backlog;
+		/**
+		 * The amount of bytes at the front of the backlog that have been written already
+		 */
+		std::size_t backlogOffset = 0;
+		bool dropped              = false;
+#ifdef PIPE_PLATFORM_UNIX
+		int handle = -1;
+#endif
+	};
+
+	const NamedPipe &m_source;
+	std::vector< Destination > m_destinations;
+	FanOutOptions m_options;
+
+#ifdef PIPE_PLATFORM_UNIX
+	/**
+	 * Handle to /dev/null into which content that has been duplicated to every destination is discarded
+	 */
+	int m_discardHandle = -1;
+	/**
+	 * Buffer for taking content out of the source that has to end up in a backlog
+	 */
+	std::vector< std::byte > m_scratch;
+	/**
+	 * The amount of bytes that could be duplicated to each destination in the current round
+	 */
+	std::vector< std::size_t > m_duplicated;
+
+	void connect(Destination &destination) noexcept;
+	void disconnect(Destination &destination) noexcept;
+	bool flush(Destination &destination) noexcept;
+	void waitForBacklogs(const Deadline &deadline, const StopToken &stopToken);
+	std::size_t discard(std::size_t size);
+#endif
+};
+
+} // namespace npipe
@@ -0,0 +1,153 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// source tree or at
+// <https://github.com/Krzmbrzl/NamedPipe/blob/main/LICENSE>.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace npipe {
+
+class MessageBatch;
+
+/**
+ * Header that precedes every message sent in framed mode. On the wire it is laid out as
+ * magic (1 byte) | flags (1 byte) | reserved (2 bytes) | payload length (4 bytes, little endian)
+ */
+struct FrameHeader {
+	/**
+	 * The size of an encoded header in bytes
+	 */
+	static constexpr std::size_t size = 8;
+	/**
+	 * Marker at the start of every header, used to detect unframed (or otherwise corrupted) data
+	 */
+	static constexpr std::byte magic = std::byte(0xF7);
+	/**
+	 * The largest payload a frame may carry. Headers announcing more are treated as corrupt, so that a damaged
+	 * header can't make the reader buffer gigabytes of data waiting for a frame that never completes.
+	 */
+	static constexpr std::uint32_t maxLength = 64 * 1024 * 1024;
+
+	/**
+	 * Flags reserved for future protocol extensions. Must currently be zero.
+	 */
+	std::uint8_t flags = 0;
+	/**
+	 * The size of the payload following the header
+	 */
+	std::uint32_t length = 0;
+
+	/**
+	 * Writes the wire representation of this header to the given buffer, which must be at least FrameHeader::size
+	 * bytes large
+	 */
+	void encode(std::byte *buffer) const noexcept;
+
+	/**
+	 * Parses a header from its wire representation
+	 *
+	 * @param buffer Pointer to (at least) FrameHeader::size bytes
+	 * @returns The parsed header
+	 *
+	 * @throws FramingException If the given bytes don't form a valid header (including headers announcing more than
+	 * maxLength bytes)
+	 */
+	[[nodiscard]] static FrameHeader decode(const std::byte *buffer);
+};
+
+/**
+ * Streaming decoder that splits raw pipe content into the framed messages it consists of. Data can be fed in
+ * arbitrary portions - frames that have only partially arrived yet are kept until the rest has been fed.
+ */
+class FrameDecoder {
+public:
+	/**
+	 * Appends the given raw data to the decoder
+	 */
+	void feed(const std::byte *data, std::size_t size);
+
+	/**
+	 * Reserves space for directly writing raw data into the decoder (e.g. via read()) without an intermediate copy.
+	 * The written data has to be made known to the decoder via commit() before calling any other function. Space
+	 * that has not been committed is reused by the next call.
+	 *
+	 * @param size The amount of bytes to reserve
+	 * @returns A pointer to the reserved space
+	 */
+	[[nodiscard]] std::byte *prepare(std::size_t size);
+
+	/**
+	 * Marks the given amount of bytes in the space handed out by the last call to prepare() as valid data
+	 */
+	void commit(std::size_t size) noexcept;
+
+	/**
+	 * Extracts the next complete message (if any)
+	 *
+	 * @param message The vector to store the message's payload in. Its capacity is reused.
+	 * @returns Whether a complete message was available
+	 *
+	 * @throws FramingException If the buffered data doesn't start with a valid frame header. The invalid data is
+	 * discarded up to the next byte that could start a header, so that subsequent calls can recover.
+	 */
+	bool next(std::vector< std::byte > &message);
+
+	/**
+	 * Extracts the next complete message (if any) into the given batch
+	 *
+	 * @param batch The batch to append the message to
+	 * @returns Whether a complete message was available
+	 *
+	 * @throws FramingException If the buffered data doesn't start with a valid frame header. The invalid data is
+	 * discarded up to the next byte that could start a header, so that subsequent calls can recover.
+	 */
+	bool next(MessageBatch &batch);
+
+	/**
+	 * @returns The amount of buffered bytes that have not been extracted as part of a message yet
+	 */
+	[[nodiscard]] std::size_t bufferedSize() const noexcept;
+
+	/**
+	 * Discards all buffered data
+	 */
+	void reset() noexcept;
+
+private:
+	std::vector< std::byte > m_buffer;
+	/**
+	 * The offset in m_buffer at which the not yet extracted data begins
+	 */
+	std::size_t m_offset = 0;
+	/**
+	 * The amount of valid bytes in m_buffer (the remainder is space handed out by prepare())
+	 */
+	std::size_t m_size = 0;
+
+	/**
+	 * Moves the not yet extracted data to the front of the buffer once the consumed part dominates
+	 */
+	void compact();
+
+	/**
+	 * Drops the buffered data up to the next byte (after the current one) that could start a frame header
+	 */
+	void resynchronize() noexcept;
+
+	/**
+	 * Removes the next complete message (if any) from the buffered data
+	 *
+	 * @param[out] length The length of the message's payload
+	 * @returns A pointer to the message's payload (valid until the next call to prepare()) or nullptr if no complete
+	 * message is available
+	 *
+	 * @throws FramingException If the buffered data doesn't start with a valid frame header
+	 */
+	const std::byte *extract(std::size_t &length);
+};
+
+} // namespace npipe
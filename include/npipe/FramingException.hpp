@@ -0,0 +1,20 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// source tree or at
+// <https://github.com/Krzmbrzl/NamedPipe/blob/main/LICENSE>.
+
+#pragma once
+
+#include "npipe/Exception.hpp"
+
+namespace npipe {
+
+/**
+ * Exception thrown when data read in framed mode doesn't form a valid frame
+ */
+class FramingException : public Exception {
+public:
+	const char *what() const noexcept { return "FramingException"; }
+};
+
+} // namespace npipe
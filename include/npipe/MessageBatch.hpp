@@ -0,0 +1,113 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// source tree or at
+// <https://github.com/Krzmbrzl/NamedPipe/blob/main/LICENSE>.
+
+#pragma once
+
+#include "npipe/ConstBuffer.hpp"
+
+#include <cstddef>
+#include <iterator>
+#include <vector>
+
+namespace npipe {
+
+/**
+ * A set of messages whose payloads are stored back-to-back in a single contiguous buffer. The message boundaries are
+ * kept in a separate array of offsets, so that the messages can be iterated without any per-message allocation.
+ * Clearing a batch keeps its memory around, so that it can be refilled without allocating either.
+ */
+class MessageBatch {
+public:
+	/**
+	 * Iterator over the messages of a batch. Dereferencing yields a view of the respective message's payload.
+	 */
+	class const_iterator {
+	public:
+		using iterator_category = std::forward_iterator_tag;
+		using value_type        = ConstBuffer;
+		using difference_type   = std::ptrdiff_t;
+		using pointer           = const ConstBuffer *;
+		using reference         = ConstBuffer;
+
+		const_iterator(const MessageBatch &batch, std::size_t index) noexcept : m_batch(&batch), m_index(index) {}
+
+		[[nodiscard]] ConstBuffer operator*() const noexcept { return (*m_batch)[m_index]; }
+
+		const_iterator &operator++() noexcept {
+			++m_index;
+			return *this;
+		}
+
+		const_iterator operator++(int) noexcept {
+			const_iterator previous = *this;
+			++m_index;
+			return previous;
+		}
+
+		[[nodiscard]] bool operator==(const const_iterator &other) const noexcept {
+			return m_batch == other.m_batch && m_index == other.m_index;
+		}
+		[[nodiscard]] bool operator!=(const const_iterator &other) const noexcept { return !(*this == other); }
+
+	private:
+		const MessageBatch *m_batch;
+		std::size_t m_index;
+	};
+
+	/**
+	 * @returns The amount of messages in this batch
+	 */
+	[[nodiscard]] std::size_t size() const noexcept { return m_offsets.size(); }
+
+	[[nodiscard]] bool empty() const noexcept { return m_offsets.empty(); }
+
+	/**
+	 * @param index The index of the message to access
+	 * @returns A view of the given message's payload. It stays valid until the batch is modified.
+	 */
+	[[nodiscard]] ConstBuffer operator[](std::size_t index) const noexcept {
+		const std::size_t end = index + 1 < m_offsets.size() ? m_offsets[index + 1] : m_arena.size();
+
+		return { m_arena.data() + m_offsets[index], end - m_offsets[index] };
+	}
+
+	[[nodiscard]] const_iterator begin() const noexcept { return const_iterator(*this, 0); }
+	[[nodiscard]] const_iterator end() const noexcept { return const_iterator(*this, size()); }
+
+	/**
+	 * @returns The buffer holding the payloads of all messages
+	 */
+	[[nodiscard]] const std::byte *data() const noexcept { return m_arena.data(); }
+
+	/**
+	 * @returns The combined size of all messages' payloads in bytes
+	 */
+	[[nodiscard]] std::size_t byteSize() const noexcept { return m_arena.size(); }
+
+	/**
+	 * Adds a message to the end of this batch
+	 *
+	 * @param payload A pointer to the beginning of the message's payload
+	 * @param size The size of the payload
+	 */
+	void append(const std::byte *payload, std::size_t size);
+
+	/**
+	 * Removes all messages from this batch while keeping the allocated memory for reuse
+	 */
+	void clear() noexcept;
+
+private:
+	/**
+	 * The payloads of all messages
+	 */
+	std::vector< std::byte > m_arena;
+	/**
+	 * The offset in m_arena at which each message begins. A message ends where the next one begins.
+	 */
+	std::vector< std::size_t > m_offsets;
+};
+
+} // namespace npipe
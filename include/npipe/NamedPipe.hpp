@@ -5,19 +5,40 @@
 
 #pragma once
 
+#include "npipe/Awaitable.hpp"
+#include "npipe/BufferPool.hpp"
+#include "npipe/ConstBuffer.hpp"
+#include "npipe/Framing.hpp"
+#include "npipe/MessageBatch.hpp"
+#include "npipe/PageAlignedBuffer.hpp"
+#include "npipe/PipeCapacity.hpp"
+#include "npipe/Result.hpp"
+#include "npipe/StopToken.hpp"
+
 #include <atomic>
 #include <chrono>
 #include <cstddef>
+#include <cstdint>
 #include <filesystem>
+#include <functional>
+#include <future>
 #include <limits>
+#include <memory>
 #include <vector>
 
+#if __has_include(<memory_resource>)
+#	include <memory_resource>
+#endif
+
 #ifdef PIPE_PLATFORM_WINDOWS
 #	include <windows.h>
 #endif
 
 namespace npipe {
 
+class CapacityController;
+class Deadline;
+class Reactor;
 
 /**
  * Wrapper class around working with NamedPipes. Its main purpose is to abstract away the implementation differences
@@ -31,9 +52,15 @@ public:
 	 * given location, this function will fail.
 	 *
 	 * @param pipePath The path at which the pipe shall be created
+	 * @param capacity The size of the pipe's kernel buffer in bytes. 0 keeps the system's default (64 KiB on Linux).
+	 * Bursty writers may require a bigger buffer in order to not run out of space while the reader is busy.
 	 * @returns A NamedPipe object wrapping the newly created pipe
+	 *
+	 * @note On Linux, the system rounds the capacity up to a power of two pages and refuses capacities beyond
+	 * /proc/sys/fs/pipe-max-size for unprivileged processes. Other Posix systems don't support choosing a capacity.
+	 * On Windows, the capacity is passed on as the pipe's buffer size.
 	 */
-	[[nodiscard]] static NamedPipe create(std::filesystem::path pipePath);
+	[[nodiscard]] static NamedPipe create(std::filesystem::path pipePath, std::size_t capacity = 0);
 
 	/**
 	 * Writes a message to the named pipe at the given location
@@ -45,10 +72,158 @@ public:
 	 * @param timeout How long this function is allowed to take. Note that the timeout is only
 	 * respected very roughly (especially on Windows) and should therefore rather be used to specify the general
 	 * order of magnitude of the timeout instead of the exact timeout-interval.
+	 *
+	 * If the pipe is full, this function waits for the reader to make room until the entire message has been
+	 * written. If that doesn't happen in time, a TimeoutException is thrown (in which case a part of the message
+	 * might have been written already - use write_partial() if this needs to be known).
 	 */
 	static void write(std::filesystem::path pipePath, const std::byte *message, std::size_t messageSize,
 					  std::chrono::milliseconds timeout = std::chrono::milliseconds(10));
 
+	/**
+	 * Writes the concatenation of the given buffers to the named pipe at the given location as a single message
+	 *
+	 * @param pipePath The path at which the pipe is expected to exist
+	 * @param buffers The buffers making up the message
+	 * @param bufferCount The amount of buffers
+	 * @param timeout How long this function is allowed to take. The remarks from NamedPipe::write apply.
+	 *
+	 * @see PipeWriter::write_gather()
+	 */
+	static void write_gather(std::filesystem::path pipePath, const ConstBuffer *buffers, std::size_t bufferCount,
+							 std::chrono::milliseconds timeout = std::chrono::milliseconds(10));
+
+	/**
+	 * Writes as much of the given message to the named pipe at the given location as possible before the timeout
+	 * expires. Whenever the pipe is full, this function waits for the reader to make room and continues writing
+	 * once there is some. Running out of time is not an error - instead the amount of bytes that made it into the
+	 * pipe is reported, so that the remainder can be sent later on.
+	 *
+	 * @param pipePath The path at which the pipe is expected to exist. If the pipe does not exist, the function
+	 * will poll for its existence until it times out.
+	 * @param message A pointer to the beginning of the message that shall be sent
+	 * @param messageSize The size of the message to write
+	 * @param timeout How long this function is allowed to take. The remarks from NamedPipe::write apply.
+	 * @returns The amount of bytes that have been committed to the pipe
+	 *
+	 * @throws TimeoutException If the pipe couldn't be opened in time
+	 *
+	 * @note On Windows, the message is either written completely or not at all
+	 */
+	static std::size_t write_partial(std::filesystem::path pipePath, const std::byte *message,
+									 std::size_t messageSize,
+									 std::chrono::milliseconds timeout = std::chrono::milliseconds(10));
+
+	/**
+	 * Non-throwing variant of write_partial() meant for hot paths
+	 *
+	 * @param pipePath The path at which the pipe is expected to exist
+	 * @param message A pointer to the beginning of the message that shall be sent
+	 * @param messageSize The size of the message to write
+	 * @param timeout How long this function is allowed to take. The remarks from NamedPipe::write apply.
+	 * @returns The outcome of the write, carrying the amount of bytes that have been committed to the pipe. See
+	 * PipeWriter::try_write for the meaning of the different states. Running out of memory is reported as
+	 * Status::Error.
+	 */
+	static Result< std::size_t > try_write(const std::filesystem::path &pipePath, const std::byte *message,
+										   std::size_t messageSize,
+										   std::chrono::milliseconds timeout = std::chrono::milliseconds(10)) noexcept;
+
+	/**
+	 * Variant of write() that doesn't make the caller wait for the pipe. Instead, the message is queued for being
+	 * written by a background thread owned by the library, which carries out all such writes one after another.
+	 *
+	 * @param pipePath The path at which the pipe is expected to exist
+	 * @param message A pointer to the beginning of the message that shall be sent. It is copied, so its memory can be
+	 * reused right away.
+	 * @param messageSize The size of the message to write
+	 * @param completion The function to report the outcome of the write to (may be empty). It is invoked on the
+	 * background thread and must neither throw nor block for long.
+	 * @param timeout How long the write itself is allowed to take while the pipe is full. If the pipe has no reader
+	 * at the time the write is carried out, the write fails right away with Status::Closed.
+	 * @returns Whether the write has been queued. If too many writes are queued already, the write is rejected and
+	 * the completion is not invoked.
+	 *
+	 * @see AsyncWriter
+	 */
+	static bool write_async(const std::filesystem::path &pipePath, const std::byte *message, std::size_t messageSize,
+							std::function< void(Result< std::size_t > result) > completion,
+							std::chrono::milliseconds timeout = std::chrono::milliseconds(10));
+
+	/**
+	 * Variant of write_async() that reports the outcome of the write via a future. If too many writes are queued
+	 * already, the future is ready right away and holds Status::Timeout.
+	 */
+	[[nodiscard]] static std::future< Result< std::size_t > >
+		write_async(const std::filesystem::path &pipePath, const std::byte *message, std::size_t messageSize,
+					std::chrono::milliseconds timeout = std::chrono::milliseconds(10));
+
+	/**
+	 * Writes the content of the given buffer to the named pipe at the given location without copying it (Linux only)
+	 *
+	 * @param pipePath The path at which the pipe is expected to exist
+	 * @param buffer The buffer to write
+	 * @param timeout How long this function is allowed to take. The remarks from NamedPipe::write apply.
+	 *
+	 * @see PipeWriter::write_zero_copy()
+	 */
+	static void write_zero_copy(std::filesystem::path pipePath, PageAlignedBuffer buffer,
+								std::chrono::milliseconds timeout = std::chrono::milliseconds(10));
+
+	/**
+	 * Writes (a range of) the file at the given location to the named pipe at the given location
+	 *
+	 * @param pipePath The path at which the pipe is expected to exist
+	 * @param filePath The path of the file to send
+	 * @param offset The position in the file to start at
+	 * @param length The maximum amount of bytes to send. Sending stops early at the end of the file.
+	 * @param timeout How long this function is allowed to take. The remarks from NamedPipe::write apply.
+	 * @returns The amount of bytes that have been committed to the pipe
+	 *
+	 * @see PipeWriter::write_file()
+	 */
+	static std::size_t write_file(std::filesystem::path pipePath, const std::filesystem::path &filePath,
+								  std::uint64_t offset = 0,
+								  std::size_t length   = (std::numeric_limits< std::size_t >::max)(),
+								  std::chrono::milliseconds timeout = std::chrono::milliseconds(10));
+
+	/**
+	 * Writes a message to the named pipe at the given location in framed mode. Every message is preceded by a small
+	 * header that allows the reading end to recover the message boundaries via read_message() - even if several
+	 * messages are written back-to-back before the reader gets to them.
+	 * As opposed to write(), this function waits for the pipe to have room for the entire frame if it is full.
+	 *
+	 * @param pipePath The path at which the pipe is expected to exist. If the pipe does not exist, the function
+	 * will poll for its existence until it times out.
+	 * @param message A pointer to the beginning of the message that shall be sent
+	 * @param messageSize The size of the message to write
+	 * @param timeout How long this function is allowed to take. The remarks from NamedPipe::write apply. A frame that
+	 * has been started may take up to PipeWriter's default frame grace period longer (see
+	 * PipeWriter::setFrameGracePeriod()).
+	 *
+	 * @throws FramingException If the message is larger than FrameHeader::maxLength
+	 *
+	 * @note Frames of up to PIPE_BUF bytes (including the header) are written atomically. Larger frames may get
+	 * interleaved with frames of other writers writing to the same pipe concurrently.
+	 */
+	static void write_message(std::filesystem::path pipePath, const std::byte *message, std::size_t messageSize,
+							  std::chrono::milliseconds timeout = std::chrono::milliseconds(10));
+
+	/**
+	 * Writes several messages to the named pipe at the given location in framed mode, using as few system calls as
+	 * possible
+	 *
+	 * @param pipePath The path at which the pipe is expected to exist
+	 * @param messages The messages to write
+	 * @param messageCount The amount of messages
+	 * @param timeout How long this function is allowed to take. The remarks from NamedPipe::write apply.
+	 * @returns The amount of messages that have been written
+	 *
+	 * @see PipeWriter::write_many()
+	 */
+	static std::size_t write_many(std::filesystem::path pipePath, const ConstBuffer *messages, std::size_t messageCount,
+								  std::chrono::milliseconds timeout = std::chrono::milliseconds(10));
+
 	/**
 	 * @returns Whether a named pipe at the given path currently exists
 	 */
@@ -82,13 +257,247 @@ public:
 	/**
 	 * Reads content from the wrapped named pipe. This function will block until there is content available or the
 	 * timeout is over. Once started this function will read all available content until EOF in a single block.
+	 * On Posix systems, the pipe stays open in between calls, so consecutive calls don't have to re-open it. The
+	 * amount of available content is queried beforehand, so that it can be read with a single read call.
 	 *
-	 * @param timeout How long this function may wait for content. Note that this will not be respected precisely.
-	 * Rather this specifies the general order of magnitude of the timeout.
+	 * @param timeout How long this function may wait for content. On Posix systems, this is measured against an
+	 * absolute deadline. On Windows it will not be respected precisely but rather specifies the general order of
+	 * magnitude of the timeout.
+	 * @param stopToken A token via which this particular read can be cancelled (causing an InterruptException)
 	 * @returns The read content
 	 */
 	[[nodiscard]] std::vector< std::byte > read_blocking(std::chrono::milliseconds timeout = std::chrono::milliseconds{
-															 (std::numeric_limits< unsigned int >::max)() }) const;
+															 (std::numeric_limits< unsigned int >::max)() },
+														 const StopToken &stopToken = StopToken()) const;
+
+	/**
+	 * Writes to the named pipe wrapped by this object in framed mode
+	 * @param message A pointer to the beginning of the message to send
+	 * @param messageSize The size of the message that shall be sent
+	 * @param timeout How long this function is allowed to take. The remarks from NamedPipe::write apply.
+	 *
+	 * @see NamedPipe::write_message()
+	 */
+	void write_message(const std::byte *message, std::size_t messageSize,
+					   std::chrono::milliseconds timeout = std::chrono::milliseconds(10)) const;
+
+#ifdef __cpp_lib_memory_resource
+	/**
+	 * Reads content from the wrapped named pipe into a vector that allocates from the given memory resource. Apart
+	 * from that, this behaves exactly like the read_blocking overload returning a std::vector. No memory is
+	 * allocated other than through the given resource, which allows e.g. for using a monotonic arena per batch of
+	 * requests.
+	 *
+	 * @param resource The memory resource to allocate from. It must outlive the returned vector.
+	 * @param timeout How long this function may wait for content
+	 * @param stopToken A token via which this particular read can be cancelled (causing an InterruptException)
+	 * @returns The read content
+	 */
+	[[nodiscard]] std::pmr::vector< std::byte > read_blocking(std::pmr::memory_resource *resource,
+															  std::chrono::milliseconds timeout =
+																  std::chrono::milliseconds{
+																	  (std::numeric_limits< unsigned int >::max)() },
+															  const StopToken &stopToken = StopToken()) const;
+#endif
+
+	/**
+	 * Reads content from the wrapped named pipe into a message borrowed from the given pool. Apart from that, this
+	 * behaves exactly like the read_blocking overload returning a vector. In steady state, receiving messages this
+	 * way doesn't allocate any memory.
+	 *
+	 * @param pool The pool to take the message's memory from. It must outlive the returned message.
+	 * @param timeout How long this function may wait for content
+	 * @param stopToken A token via which this particular read can be cancelled (causing an InterruptException)
+	 * @returns The read content
+	 */
+	[[nodiscard]] Message read_blocking(BufferPool &pool,
+										std::chrono::milliseconds timeout = std::chrono::milliseconds{
+											(std::numeric_limits< unsigned int >::max)() },
+										const StopToken &stopToken = StopToken()) const;
+
+	/**
+	 * Reads content from the wrapped named pipe straight into the given buffer. This function will block until there
+	 * is content available or the timeout is over and then reads as much of the available content as fits into the
+	 * buffer. Content that doesn't fit remains in the pipe for the next read.
+	 *
+	 * @param buffer The buffer to read into
+	 * @param bufferSize The size of the buffer
+	 * @param timeout How long this function may wait for content. The remarks from read_blocking apply.
+	 * @param stopToken A token via which this particular read can be cancelled (causing an InterruptException)
+	 * @returns The amount of bytes that have been read into the buffer
+	 *
+	 * @note On Windows the content is read via read_blocking and buffered internally
+	 */
+	std::size_t read_into(std::byte *buffer, std::size_t bufferSize,
+						  std::chrono::milliseconds timeout = std::chrono::milliseconds{
+							  (std::numeric_limits< unsigned int >::max)() },
+						  const StopToken &stopToken = StopToken()) const;
+
+	/**
+	 * Non-throwing variant of read_into() meant for hot paths. On Unix, neither exceptions nor memory allocations are
+	 * involved.
+	 *
+	 * @param buffer The buffer to read into
+	 * @param bufferSize The size of the buffer
+	 * @param timeout How long this function may wait for content. The remarks from read_blocking apply.
+	 * @param stopToken A token via which this particular read can be cancelled
+	 * @returns The outcome of the read, carrying the amount of bytes that have been read into the buffer. Running out
+	 * of time yields Status::Timeout, cancellation Status::Interrupted and reading from a destroyed pipe
+	 * Status::Closed.
+	 */
+	Result< std::size_t > try_read(std::byte *buffer, std::size_t bufferSize,
+								   std::chrono::milliseconds timeout = std::chrono::milliseconds{
+									   (std::numeric_limits< unsigned int >::max)() },
+								   const StopToken &stopToken = StopToken()) const noexcept;
+
+	/**
+	 * Reads the next message that has been sent in framed mode (see write_message()). Each call returns exactly one
+	 * message, regardless of how its bytes were split or combined during transport. Content that has already been
+	 * received but belongs to subsequent messages is kept for subsequent calls.
+	 *
+	 * @param timeout How long this function may wait for the message to arrive. The remarks from read_blocking apply.
+	 * @param stopToken A token via which this particular read can be cancelled (causing an InterruptException)
+	 * @returns The payload of the read message
+	 *
+	 * @throws FramingException If the pipe's content is not framed
+	 *
+	 * @note Reading framed and unframed content from the same pipe is not supported
+	 */
+	[[nodiscard]] std::vector< std::byte > read_message(std::chrono::milliseconds timeout = std::chrono::milliseconds{
+															(std::numeric_limits< unsigned int >::max)() },
+														const StopToken &stopToken = StopToken()) const;
+
+	/**
+	 * Reads all messages that have been sent in framed mode (see write_message()) and are available right away. This
+	 * function blocks until at least one complete message has arrived or the timeout is over. All messages are
+	 * stored in the given batch, which allows to process many small messages per wakeup without allocating memory
+	 * for each of them.
+	 *
+	 * @param batch The batch to store the messages in. Its previous content is discarded, but its memory is reused.
+	 * @param timeout How long this function may wait for a message to arrive. The remarks from read_blocking apply.
+	 * @param stopToken A token via which this particular read can be cancelled (causing an InterruptException)
+	 * @returns The amount of messages that have been read
+	 *
+	 * @throws FramingException If the pipe's content is not framed
+	 */
+	std::size_t read_batch(MessageBatch &batch,
+						   std::chrono::milliseconds timeout = std::chrono::milliseconds{
+							   (std::numeric_limits< unsigned int >::max)() },
+						   const StopToken &stopToken = StopToken()) const;
+
+	/**
+	 * Convenience overload of read_batch() that returns a new batch
+	 */
+	[[nodiscard]] MessageBatch read_batch(std::chrono::milliseconds timeout = std::chrono::milliseconds{
+											  (std::numeric_limits< unsigned int >::max)() },
+										  const StopToken &stopToken = StopToken()) const;
+
+#ifdef PIPE_PLATFORM_UNIX
+	/**
+	 * Moves content from the wrapped named pipe to the given file descriptor (e.g. a file or a socket) without
+	 * copying it through user space. This function will block until there is content available or the timeout is
+	 * over and then relays all of the available content.
+	 *
+	 * @param fd The file descriptor to move the content to. Non-blocking descriptors are waited on if they can't
+	 * take any more data.
+	 * @param timeout How long this function may wait for content (or for the destination to have room). The remarks
+	 * from read_blocking apply.
+	 * @param stopToken A token via which this particular relay can be cancelled (causing an InterruptException)
+	 * @param chunkSize The maximum amount of bytes to move in one go
+	 * @returns The amount of bytes that have been moved. If the timeout expires or the relay gets cancelled after
+	 * some content has been moved already, that amount is returned instead of throwing an exception.
+	 *
+	 * @note On Linux, this uses splice(). Elsewhere (or if the destination doesn't support splicing), the content is
+	 * copied through a buffer of chunkSize bytes. Content that has been taken out of the pipe that way is always
+	 * written completely, regardless of the timeout.
+	 */
+	std::size_t relay_to(int fd,
+						 std::chrono::milliseconds timeout = std::chrono::milliseconds{
+							 (std::numeric_limits< unsigned int >::max)() },
+						 const StopToken &stopToken = StopToken(), std::size_t chunkSize = 64 * 1024) const;
+
+	/**
+	 * Asynchronous variant of read_blocking() for coroutines: `co_await pipe.async_read(reactor)` suspends the
+	 * calling coroutine until there is content available instead of blocking the calling thread. The coroutine is
+	 * resumed on the thread running the given reactor.
+	 *
+	 * @param reactor The reactor to wait on the pipe with. It has to outlive the read.
+	 * @param timeout How long to wait for content
+	 * @param stopToken A token via which this particular read can be cancelled (causing an InterruptException)
+	 * @returns An awaitable that yields all available content once awaited
+	 */
+	[[nodiscard]] ReadAwaitable async_read(Reactor &reactor,
+										   std::chrono::milliseconds timeout = std::chrono::milliseconds{
+											   (std::numeric_limits< unsigned int >::max)() },
+										   StopToken stopToken = StopToken()) const;
+
+	/**
+	 * Non-blocking variant of read_batch() for driving the pipe from an external event loop: Reads whatever is
+	 * available right now and returns the messages that have arrived completely. Partially received messages are
+	 * kept internally until the rest of them arrives.
+	 *
+	 * @param batch The batch to store the messages in. Its previous content is discarded, but its memory is reused.
+	 * @returns The amount of messages that have been read (possibly 0)
+	 *
+	 * @throws FramingException If the pipe's content is not framed
+	 * @throws PipeException If the pipe has been destroyed or reading from it fails
+	 *
+	 * @see native_handle()
+	 */
+	std::size_t read_available(MessageBatch &batch) const;
+
+	/**
+	 * @returns The (non-blocking) file descriptor of the pipe's reading end, so that it can be registered with an
+	 * external event loop (e.g. epoll, libevent or asio). Once it is reported as readable, call read_available().
+	 * The descriptor stays owned by this object and must not be read from directly, as that would get in the way
+	 * of the message framing. As this object holds a writing end of the pipe as well, the descriptor never reports
+	 * end-of-file or a hang-up.
+	 */
+	[[nodiscard]] int native_handle() const noexcept;
+#endif
+
+#ifdef PIPE_PLATFORM_UNIX
+	/**
+	 * Changes the size of the pipe's kernel buffer. This affects all writers connected to the pipe.
+	 *
+	 * @param capacity The requested capacity in bytes. The system rounds it up to a power of two pages.
+	 * @returns The resulting capacity
+	 *
+	 * @throws PipeException If the pipe can't be resized (e.g. because the capacity exceeds the system's limit, the
+	 * current content doesn't fit into the requested capacity or resizing pipes isn't supported on this system)
+	 */
+	std::size_t setCapacity(std::size_t capacity);
+
+	/**
+	 * Lets the pipe's capacity follow the load: Whenever a read finds the pipe filled beyond the configured threshold
+	 * several times in a row, the capacity gets doubled. Once the pipe has been idle for long enough, the capacity
+	 * is halved again. The pipe is inspected whenever a read finds content, regularly while a read is waiting for
+	 * content and whenever getCapacityMetrics() is called. So a pipe that is neither read from nor monitored keeps
+	 * its capacity.
+	 *
+	 * @param options The settings to use
+	 *
+	 * @note Enabling or disabling adaptive capacity must not happen concurrently with reading from the pipe
+	 * @note Only supported on Linux. Elsewhere, the fill level is tracked but the capacity never changes.
+	 */
+	void enableAdaptiveCapacity(const AdaptiveCapacityOptions &options = AdaptiveCapacityOptions());
+
+	/**
+	 * Stops adapting the pipe's capacity. The capacity stays at whatever it is at the moment.
+	 */
+	void disableAdaptiveCapacity();
+
+	/**
+	 * @returns The current buffer usage of the pipe. Peak fill level and resize counts are only tracked while
+	 * adaptive capacity is enabled. In that case, an idle pipe gets shrunk before its metrics are taken.
+	 */
+	[[nodiscard]] CapacityMetrics getCapacityMetrics() const;
+#endif
+
+	/**
+	 * @returns The size of the pipe's kernel buffer in bytes or 0 if that can't be determined on this system
+	 */
+	[[nodiscard]] std::size_t getCapacity() const;
 
 	/**
 	 * @returns The path of the wrapped named pipe
@@ -105,7 +514,7 @@ public:
 	void destroy();
 
 	/**
-	 * Interrupt any ongoing read or write process.
+	 * Interrupt any ongoing read or write process. On Posix systems, a waiting read is woken up immediately.
 	 * Note: Once interrupted, the pipe has to be reconstructed before using it again
 	 */
 	void interrupt();
@@ -116,17 +525,50 @@ public:
 	operator bool() const noexcept;
 
 private:
+	friend class FanOut;
+	friend class ReadAwaitable;
+	friend class Reactor;
+
 	/**
 	 * The path to the wrapped pipe
 	 */
 	std::filesystem::path m_pipePath;
 	mutable std::atomic_bool m_break = false;
+	/**
+	 * Decoder holding framed content that has been received but not yet returned by read_message
+	 */
+	mutable FrameDecoder m_decoder;
 
 #ifdef PIPE_PLATFORM_WINDOWS
 	/**
 	 * On Windows this holds the handle to the pipe. On other platforms this variable doesn't exist.
 	 */
 	HANDLE m_handle = INVALID_HANDLE_VALUE;
+	/**
+	 * Content that has been read from the pipe but didn't fit into the buffer passed to read_into
+	 */
+	mutable std::vector< std::byte > m_unread;
+#endif
+
+#ifdef PIPE_PLATFORM_UNIX
+	/**
+	 * On Posix systems this holds the (non-blocking) reading end of the pipe, which is kept open for as long as
+	 * this object lives. On other platforms this variable doesn't exist.
+	 */
+	int m_readHandle = -1;
+	/**
+	 * A writing end of the pipe that is held open next to the reading end. This ensures that the pipe always has
+	 * at least one writer, so it never reports EOF/POLLHUP in between two external writers.
+	 */
+	int m_guardHandle = -1;
+	/**
+	 * Source used to wake up any ongoing wait on the pipe once this wrapper gets interrupted
+	 */
+	StopSource m_interruptSource;
+	/**
+	 * Adapts the pipe's capacity to the observed fill level. Only set while adaptive capacity is enabled.
+	 */
+	std::unique_ptr< CapacityController > m_capacityController;
 #endif
 
 	/**
@@ -136,6 +578,18 @@ private:
 	 * @param The path to the pipe that should be wrapped by this object
 	 */
 	explicit NamedPipe(const std::filesystem::path &path);
+
+#ifdef PIPE_PLATFORM_UNIX
+	/**
+	 * Blocks until there is content available to be read from the pipe
+	 *
+	 * @param deadline The point in time until which to wait at most
+	 * @param stopToken A token via which waiting can be cancelled
+	 * @returns Status::Ok if there is content available, Status::Timeout if none has become available before the
+	 * deadline, Status::Interrupted if waiting got interrupted and Status::Closed if the pipe has been destroyed
+	 */
+	Status waitForInput(const Deadline &deadline, const StopToken &stopToken) const noexcept;
+#endif
 };
 
 
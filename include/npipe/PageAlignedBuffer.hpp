@@ -0,0 +1,70 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// source tree or at
+// <https://github.com/Krzmbrzl/NamedPipe/blob/main/LICENSE>.
+
+#pragma once
+
+#include <cstddef>
+
+namespace npipe {
+
+/**
+ * A buffer whose memory starts at a page boundary and spans whole pages. Such buffers can be handed to the kernel
+ * without copying (see PipeWriter::write_zero_copy). The memory is zero-initialized.
+ */
+class PageAlignedBuffer {
+public:
+	/**
+	 * Allocates a new buffer
+	 *
+	 * @param size The size of the buffer. The underlying allocation is rounded up to a multiple of the page size.
+	 *
+	 * @throws std::bad_alloc If the memory couldn't be allocated
+	 */
+	explicit PageAlignedBuffer(std::size_t size);
+
+	/**
+	 * Creates an empty buffer
+	 */
+	PageAlignedBuffer() noexcept = default;
+	~PageAlignedBuffer();
+
+	PageAlignedBuffer(const PageAlignedBuffer &) = delete;
+	PageAlignedBuffer &operator=(const PageAlignedBuffer &) = delete;
+
+	PageAlignedBuffer(PageAlignedBuffer &&other) noexcept;
+	PageAlignedBuffer &operator=(PageAlignedBuffer &&other) noexcept;
+
+	[[nodiscard]] std::byte *data() noexcept { return m_buffer; }
+	[[nodiscard]] const std::byte *data() const noexcept { return m_buffer; }
+
+	[[nodiscard]] std::byte *begin() noexcept { return m_buffer; }
+	[[nodiscard]] const std::byte *begin() const noexcept { return m_buffer; }
+	[[nodiscard]] std::byte *end() noexcept { return m_buffer + m_size; }
+	[[nodiscard]] const std::byte *end() const noexcept { return m_buffer + m_size; }
+
+	/**
+	 * @returns The size of the buffer in bytes
+	 */
+	[[nodiscard]] std::size_t size() const noexcept { return m_size; }
+
+	/**
+	 * @returns The size of the underlying allocation in bytes (always a multiple of the page size)
+	 */
+	[[nodiscard]] std::size_t capacity() const noexcept { return m_capacity; }
+
+	[[nodiscard]] bool empty() const noexcept { return m_size == 0; }
+
+	/**
+	 * @returns The size of a memory page on this system
+	 */
+	[[nodiscard]] static std::size_t pageSize() noexcept;
+
+private:
+	std::byte *m_buffer    = nullptr;
+	std::size_t m_size     = 0;
+	std::size_t m_capacity = 0;
+};
+
+} // namespace npipe
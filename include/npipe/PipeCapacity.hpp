@@ -0,0 +1,78 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// source tree or at
+// <https://github.com/Krzmbrzl/NamedPipe/blob/main/LICENSE>.
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace npipe {
+
+/**
+ * Settings for adapting a pipe's kernel buffer size to the observed load (see NamedPipe::enableAdaptiveCapacity)
+ */
+struct AdaptiveCapacityOptions {
+	/**
+	 * The capacity the pipe is never shrunk below
+	 */
+	std::size_t minCapacity = 64 * 1024;
+	/**
+	 * The capacity the pipe is never grown beyond. 0 means the system's limit for unprivileged processes
+	 * (/proc/sys/fs/pipe-max-size on Linux).
+	 */
+	std::size_t maxCapacity = 0;
+	/**
+	 * The fill level (as a fraction of the current capacity) from which on a read counts towards growing the pipe
+	 */
+	double growThreshold = 0.75;
+	/**
+	 * The amount of consecutive reads that have to find the pipe filled beyond growThreshold before its capacity is
+	 * doubled
+	 */
+	std::size_t growAfter = 3;
+	/**
+	 * The fill level (as a fraction of the current capacity) up to which the pipe is considered idle
+	 */
+	double idleThreshold = 0.1;
+	/**
+	 * How long the pipe has to be idle before its capacity is halved. Subsequent shrinking steps are at least this
+	 * far apart as well.
+	 */
+	std::chrono::milliseconds shrinkAfter = std::chrono::seconds(5);
+};
+
+/**
+ * A snapshot of a pipe's buffer usage
+ */
+struct CapacityMetrics {
+	/**
+	 * The current size of the pipe's kernel buffer in bytes (0 if it can't be determined)
+	 */
+	std::size_t capacity = 0;
+	/**
+	 * The amount of bytes that are currently waiting in the pipe
+	 */
+	std::size_t fillLevel = 0;
+	/**
+	 * The highest amount of bytes a read has found waiting in the pipe while adaptive capacity was enabled
+	 */
+	std::size_t peakFillLevel = 0;
+	/**
+	 * The amount of times the capacity has been grown automatically
+	 */
+	std::uint64_t growCount = 0;
+	/**
+	 * The amount of times the capacity has been shrunk automatically
+	 */
+	std::uint64_t shrinkCount = 0;
+	/**
+	 * The amount of automatic resizes the system has refused (e.g. because the per-user limit of pipe buffer pages
+	 * has been reached or because the content didn't fit into the shrunk buffer)
+	 */
+	std::uint64_t failedResizeCount = 0;
+};
+
+} // namespace npipe
@@ -38,6 +38,11 @@ public:
 	}
 
 	const char *what() const noexcept { return m_message.c_str(); }
+
+	/**
+	 * @returns The encountered error code
+	 */
+	error_code_t errorCode() const noexcept { return m_errorCode; }
 };
 
 } // namespace npipe
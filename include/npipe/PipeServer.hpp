@@ -0,0 +1,118 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// source tree or at
+// <https://github.com/Krzmbrzl/NamedPipe/blob/main/LICENSE>.
+
+#pragma once
+
+#include "npipe/NamedPipe.hpp"
+#include "npipe/StopToken.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace npipe {
+
+class WorkStealingPool;
+
+/**
+ * Settings for a PipeServer
+ */
+struct PipeServerOptions {
+	/**
+	 * The amount of threads handling messages. 0 means one per hardware thread.
+	 */
+	std::size_t threadCount = 0;
+};
+
+/**
+ * Reads framed messages (see NamedPipe::read_message) from a pipe and hands them to a pool of worker threads. As
+ * opposed to handling messages on the reading thread, a slow message doesn't hold up the ones behind it: Idle workers
+ * steal queued messages from busy ones.
+ *
+ * Messages are handled concurrently and in no particular order, unless they are assigned a key: Messages with the
+ * same key are handled one after another, in the order in which they have been read.
+ */
+class PipeServer {
+public:
+	/**
+	 * Function handling a single message. It is invoked on one of the worker threads and must not throw.
+	 */
+	using handler_t = std::function< void(std::vector< std::byte > message) >;
+	/**
+	 * Function assigning an ordering key to a message (or none, if the message doesn't have to be ordered). It is
+	 * invoked on the reading thread.
+	 */
+	using key_function_t = std::function< std::optional< std::uint64_t >(const std::vector< std::byte > &message) >;
+
+	/**
+	 * Starts reading from the given pipe
+	 *
+	 * @param pipe The pipe to read from. It has to outlive this object.
+	 * @param handler The function handling the messages
+	 * @param keyOf The function assigning ordering keys to messages. If empty, no message is ordered.
+	 * @param options The settings to use
+	 */
+	PipeServer(const NamedPipe &pipe, handler_t handler, key_function_t keyOf = key_function_t(),
+			   PipeServerOptions options = PipeServerOptions());
+	/**
+	 * Stops the server (see stop()), discarding any error
+	 */
+	~PipeServer();
+
+	PipeServer(const PipeServer &) = delete;
+	PipeServer &operator=(const PipeServer &) = delete;
+
+	/**
+	 * Stops reading from the pipe and waits for all messages that have been read already to be handled. Calling
+	 * this function multiple times is allowed.
+	 *
+	 * @throws Exception The error that has made reading from the pipe fail (if any)
+	 */
+	void stop();
+
+	/**
+	 * @returns The amount of threads handling messages
+	 */
+	[[nodiscard]] std::size_t threadCount() const noexcept;
+
+private:
+	const NamedPipe &m_pipe;
+	handler_t m_handler;
+	key_function_t m_keyOf;
+	std::unique_ptr< WorkStealingPool > m_pool;
+	std::size_t m_threadCount;
+
+	std::mutex m_strandMutex;
+	/**
+	 * Messages waiting to be handled per ordering key. The front message is the one that is being handled right
+	 * now. Keys without pending messages are removed.
+	 */
+	std::unordered_map< std::uint64_t, std::deque< std::vector< std::byte > > > m_strands;
+
+	StopSource m_stopSource;
+	std::exception_ptr m_error;
+	std::thread m_reader;
+
+	void runReader();
+	void dispatch(std::vector< std::byte > message);
+	/**
+	 * Handles the front message of the given key's strand and schedules the next one
+	 */
+	void runStrand(std::uint64_t key);
+	/**
+	 * Stops reading and waits for pending messages to be handled
+	 */
+	void shutdown() noexcept;
+};
+
+} // namespace npipe
@@ -0,0 +1,329 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// source tree or at
+// <https://github.com/Krzmbrzl/NamedPipe/blob/main/LICENSE>.
+
+#pragma once
+
+#include "npipe/Awaitable.hpp"
+#include "npipe/ConstBuffer.hpp"
+#include "npipe/PageAlignedBuffer.hpp"
+#include "npipe/Result.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <limits>
+
+namespace npipe {
+
+class Deadline;
+class Reactor;
+
+/**
+ * Writing end of a named pipe that keeps its connection to the pipe open across multiple writes. As opposed to
+ * NamedPipe::write, the pipe does not have to be looked up, opened and closed again for every single message.
+ * If the reading end goes away, the writer transparently reconnects on the next write.
+ *
+ * @note On Windows this currently forwards every write to NamedPipe::write
+ */
+class PipeWriter {
+public:
+	/**
+	 * Creates a writer for the pipe at the given location. The pipe is not required to exist yet as the
+	 * connection is only established on the first write.
+	 *
+	 * @param pipePath The path at which the pipe is expected to exist
+	 */
+	explicit PipeWriter(std::filesystem::path pipePath);
+
+	/**
+	 * Creates an empty (invalid) instance
+	 */
+	PipeWriter() = default;
+	~PipeWriter();
+
+	PipeWriter(const PipeWriter &) = delete;
+	PipeWriter &operator=(const PipeWriter &) = delete;
+
+	PipeWriter(PipeWriter &&other) noexcept;
+	PipeWriter &operator=(PipeWriter &&other) noexcept;
+
+	/**
+	 * Writes a message to the pipe. If not yet connected (or if the connection has been lost in the meantime), this
+	 * function will wait for the pipe to become available until it times out. If the pipe is full, this function
+	 * waits for the reader to make room until the entire message has been written.
+	 *
+	 * @param message A pointer to the beginning of the message that shall be sent
+	 * @param messageSize The size of the message to write
+	 * @param timeout How long this function is allowed to take
+	 *
+	 * @see NamedPipe::write()
+	 */
+	void write(const std::byte *message, std::size_t messageSize,
+			   std::chrono::milliseconds timeout = std::chrono::milliseconds(10));
+
+	/**
+	 * Writes the concatenation of the given buffers to the pipe as a single message, without having to concatenate
+	 * them in memory first. Apart from that, this behaves exactly like write().
+	 *
+	 * @param buffers The buffers making up the message
+	 * @param bufferCount The amount of buffers
+	 * @param timeout How long this function is allowed to take
+	 *
+	 * @note If the total size doesn't exceed PIPE_BUF, the message is written atomically
+	 * @see write()
+	 */
+	void write_gather(const ConstBuffer *buffers, std::size_t bufferCount,
+					  std::chrono::milliseconds timeout = std::chrono::milliseconds(10));
+
+	/**
+	 * Non-throwing variant of write_gather() that reports how far the write got. Like try_write(), running out of
+	 * time after having written part of the buffers is reported as Status::Timeout along with the amount of bytes
+	 * that have been committed to the pipe, so that the write can be resumed from exactly that point.
+	 *
+	 * @param buffers The buffers making up the message
+	 * @param bufferCount The amount of buffers
+	 * @param timeout How long this function is allowed to take
+	 * @returns The outcome of the write (see try_write())
+	 */
+	Result< std::size_t > try_write_gather(const ConstBuffer *buffers, std::size_t bufferCount,
+										   std::chrono::milliseconds timeout = std::chrono::milliseconds(10)) noexcept;
+
+	/**
+	 * Writes as much of the given message to the pipe as possible before the timeout expires. If the pipe is full,
+	 * this function keeps waiting for the reader to make room and continues writing whenever there is some.
+	 * As opposed to write(), running out of time is not an error. Instead, the amount of bytes that made it into
+	 * the pipe is reported, so that the remainder can be sent later on.
+	 *
+	 * @param message A pointer to the beginning of the message that shall be sent
+	 * @param messageSize The size of the message to write
+	 * @param timeout How long this function is allowed to take
+	 * @returns The amount of bytes that have been committed to the pipe
+	 *
+	 * @throws TimeoutException If the pipe couldn't be connected to in time
+	 */
+	std::size_t write_partial(const std::byte *message, std::size_t messageSize,
+							  std::chrono::milliseconds timeout = std::chrono::milliseconds(10));
+
+	/**
+	 * Non-throwing variant of write_partial() meant for hot paths. Neither exceptions nor memory allocations are
+	 * involved.
+	 *
+	 * @param message A pointer to the beginning of the message that shall be sent
+	 * @param messageSize The size of the message to write
+	 * @param timeout How long this function is allowed to take
+	 * @returns The outcome of the write, carrying the amount of bytes that have been committed to the pipe. If no
+	 * reader could be reached in time, the status is Status::Closed. If the message could only be written partially,
+	 * the status is Status::Timeout.
+	 *
+	 * @note On Windows, this is a wrapper around write() that translates exceptions into status codes
+	 */
+	Result< std::size_t > try_write(const std::byte *message, std::size_t messageSize,
+									std::chrono::milliseconds timeout = std::chrono::milliseconds(10)) noexcept;
+
+	/**
+	 * Writes the content of the given buffer to the pipe without copying it. On Linux, the buffer's pages are
+	 * gifted to the kernel (via vmsplice), so that the reader receives them straight from this process's memory.
+	 * Small buffers (and all buffers on other platforms) are written as in write().
+	 *
+	 * @note As the buffer is given up, every write needs a freshly allocated buffer. Allocating and filling it
+	 * usually costs more than copying a reused buffer into the pipe, so this only pays off for payloads that end up
+	 * in fresh page-aligned memory anyway (see the zero_copy_throughput benchmark).
+	 *
+	 * @param buffer The buffer to write. Ownership is transferred as the memory must not be modified until it has
+	 * been read from the pipe.
+	 * @param timeout How long this function is allowed to take
+	 *
+	 * @see write()
+	 */
+	void write_zero_copy(PageAlignedBuffer buffer, std::chrono::milliseconds timeout = std::chrono::milliseconds(10));
+
+#ifdef PIPE_PLATFORM_UNIX
+	/**
+	 * Writes (a range of) the given file's content to the pipe. On Linux, the content is moved from the page cache
+	 * into the pipe via splice(), so that it is never copied through user space. Like write_partial(), running out of
+	 * time after having connected to the pipe is not an error - the returned amount tells where to resume.
+	 *
+	 * @param fd The file descriptor of the file to send. Its file offset is not changed.
+	 * @param offset The position in the file to start at
+	 * @param length The maximum amount of bytes to send. Sending stops early at the end of the file.
+	 * @param timeout How long this function is allowed to take
+	 * @returns The amount of bytes that have been committed to the pipe
+	 *
+	 * @throws TimeoutException If the pipe couldn't be opened in time
+	 */
+	std::size_t write_file(int fd, std::uint64_t offset = 0,
+						   std::size_t length                = (std::numeric_limits< std::size_t >::max)(),
+						   std::chrono::milliseconds timeout = std::chrono::milliseconds(10));
+
+	/**
+	 * Changes the size of the pipe's kernel buffer, connecting to the pipe first if necessary. This affects the
+	 * reader and all other writers of the pipe as well.
+	 *
+	 * @param capacity The requested capacity in bytes. The system rounds it up to a power of two pages.
+	 * @param timeout How long connecting to the pipe is allowed to take
+	 * @returns The resulting capacity
+	 *
+	 * @throws TimeoutException If the pipe couldn't be opened in time
+	 * @throws PipeException If the pipe can't be resized (see NamedPipe::setCapacity)
+	 */
+	std::size_t setCapacity(std::size_t capacity, std::chrono::milliseconds timeout = std::chrono::milliseconds(10));
+
+	/**
+	 * Asynchronous variant of write() for coroutines: `co_await writer.async_write(reactor, message, size)` suspends
+	 * the calling coroutine while the pipe is full (or has no reader) instead of blocking the calling thread. The
+	 * coroutine is resumed on the thread running the given reactor.
+	 *
+	 * @param reactor The reactor to wait on the pipe with. It has to outlive the write.
+	 * @param message A pointer to the beginning of the message that shall be sent. It has to stay valid until the
+	 * write is over.
+	 * @param messageSize The size of the message
+	 * @param timeout How long the write is allowed to take
+	 * @param stopToken A token via which the write can be cancelled (causing an InterruptException)
+	 * @returns An awaitable that completes once the message has been written
+	 *
+	 * @note While the pipe has no reader, the write checks back periodically
+	 */
+	[[nodiscard]] WriteAwaitable async_write(Reactor &reactor, const std::byte *message, std::size_t messageSize,
+											 std::chrono::milliseconds timeout = std::chrono::milliseconds(10),
+											 StopToken stopToken             = StopToken());
+
+	/**
+	 * @returns The file descriptor of the current connection to the pipe or -1 if not connected
+	 */
+	[[nodiscard]] int native_handle() const noexcept;
+
+	/**
+	 * @param timeout How long connecting to the pipe is allowed to take
+	 * @returns The size of the pipe's kernel buffer in bytes or 0 if that can't be determined on this system
+	 *
+	 * @throws TimeoutException If the pipe couldn't be opened in time
+	 */
+	[[nodiscard]] std::size_t getCapacity(std::chrono::milliseconds timeout = std::chrono::milliseconds(10));
+#endif
+
+	/**
+	 * Writes (a range of) the file at the given location to the pipe
+	 *
+	 * @param filePath The path of the file to send
+	 * @param offset The position in the file to start at
+	 * @param length The maximum amount of bytes to send. Sending stops early at the end of the file.
+	 * @param timeout How long this function is allowed to take
+	 * @returns The amount of bytes that have been committed to the pipe
+	 *
+	 * @throws TimeoutException If the pipe couldn't be opened in time
+	 *
+	 * @note On Windows, the range is read into memory and written as a whole
+	 * @see write_file(int, std::uint64_t, std::size_t, std::chrono::milliseconds)
+	 */
+	std::size_t write_file(const std::filesystem::path &filePath, std::uint64_t offset = 0,
+						   std::size_t length                = (std::numeric_limits< std::size_t >::max)(),
+						   std::chrono::milliseconds timeout = std::chrono::milliseconds(10));
+
+	/**
+	 * Writes a message to the pipe in framed mode, so that the reading end can recover the message boundaries via
+	 * NamedPipe::read_message.
+	 *
+	 * @param message A pointer to the beginning of the message that shall be sent
+	 * @param messageSize The size of the message to write
+	 * @param timeout How long this function is allowed to take. Once part of the frame has been written, the rest of
+	 * it may take up to the frame grace period longer (see setFrameGracePeriod()), as a torn frame would corrupt
+	 * everything written to the pipe after it. If the frame can't be completed within that period either, the
+	 * connection is closed before the TimeoutException is thrown, so that no further frame is appended to the torn
+	 * one.
+	 *
+	 * @see NamedPipe::write_message()
+	 */
+	void write_message(const std::byte *message, std::size_t messageSize,
+					   std::chrono::milliseconds timeout = std::chrono::milliseconds(10));
+
+	/**
+	 * Writes several messages to the pipe in framed mode (see write_message()) using as few system calls as
+	 * possible. Consecutive frames are grouped such that every group fits into PIPE_BUF bytes and is thus written
+	 * atomically. Only frames that exceed PIPE_BUF on their own may get interleaved with frames of other writers.
+	 *
+	 * @param messages The messages to write
+	 * @param messageCount The amount of messages
+	 * @param timeout How long this function is allowed to take. A frame that has been started before the timeout
+	 * expired is finished within the frame grace period. If that fails, the connection is closed (see
+	 * write_message()).
+	 * @returns The amount of messages that have been written completely. Messages are written in order, so this is
+	 * the index of the first message that has to be resent.
+	 *
+	 * @throws TimeoutException If the pipe couldn't be opened in time
+	 */
+	std::size_t write_many(const ConstBuffer *messages, std::size_t messageCount,
+						   std::chrono::milliseconds timeout = std::chrono::milliseconds(10));
+
+	/**
+	 * Connects to the pipe unless a connection exists already. Writing connects implicitly, so this is only needed
+	 * for checking whether the pipe currently has a reader.
+	 *
+	 * @param timeout How long to wait for the pipe to become available
+	 * @returns Whether the pipe could be connected to (on Windows: whether the pipe is ready to accept a write)
+	 */
+	bool try_connect(std::chrono::milliseconds timeout = std::chrono::milliseconds(0)) noexcept;
+
+	/**
+	 * Sets how long the remainder of a frame may take to be written once the timeout of write_message() or
+	 * write_many() has expired in the middle of the frame. Defaults to one second.
+	 *
+	 * @note Has no effect on Windows, where every frame is written as a whole
+	 */
+	void setFrameGracePeriod(std::chrono::milliseconds gracePeriod) noexcept;
+
+	/**
+	 * @returns How long the remainder of a started frame may take to be written (see setFrameGracePeriod())
+	 */
+	[[nodiscard]] std::chrono::milliseconds getFrameGracePeriod() const noexcept;
+
+	/**
+	 * Closes the connection to the pipe (if any). The next write will connect again.
+	 */
+	void disconnect() noexcept;
+
+	/**
+	 * @returns Whether this writer currently holds an open connection to the pipe
+	 */
+	[[nodiscard]] bool isConnected() const noexcept;
+
+	/**
+	 * @returns The path of the pipe this writer writes to
+	 */
+	[[nodiscard]] std::filesystem::path getPath() const noexcept;
+
+	/**
+	 * @returns Whether this writer is currently in a valid state
+	 */
+	operator bool() const noexcept;
+
+private:
+	/**
+	 * The path to the pipe to write to
+	 */
+	std::filesystem::path m_pipePath;
+	/**
+	 * How long the remainder of a started frame may take to be written after the write's timeout has expired
+	 */
+	std::chrono::milliseconds m_frameGracePeriod = std::chrono::seconds(1);
+
+#ifdef PIPE_PLATFORM_UNIX
+	/**
+	 * The file descriptor of the connected pipe or -1 if currently not connected
+	 */
+	int m_handle = -1;
+
+	/**
+	 * Connects to the pipe unless a connection exists already
+	 *
+	 * @param deadline The point in time at which to give up
+	 *
+	 * @throws TimeoutException If the pipe couldn't be opened in time
+	 */
+	void connect(const Deadline &deadline);
+#endif
+};
+
+} // namespace npipe
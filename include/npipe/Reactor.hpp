@@ -0,0 +1,212 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// source tree or at
+// <https://github.com/Krzmbrzl/NamedPipe/blob/main/LICENSE>.
+
+#pragma once
+
+#include "npipe/NamedPipe.hpp"
+#include "npipe/Result.hpp"
+#include "npipe/StopToken.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#ifdef PIPE_PLATFORM_UNIX
+
+namespace npipe {
+
+class Deadline;
+class WakeupEvent;
+
+/**
+ * Waits on any amount of pipes at once and invokes a callback for every pipe that has content available. This
+ * allows serving many pipes from a single thread instead of blocking a thread per pipe in read_blocking. On Linux,
+ * the pipes are waited on via epoll, elsewhere via poll.
+ *
+ * Callbacks are invoked on the thread that runs the reactor. They are expected to read the available content (e.g.
+ * via NamedPipe::read_batch or NamedPipe::read_blocking with a timeout of 0), as they are invoked again for as long
+ * as there is content left in the pipe.
+ */
+class Reactor {
+public:
+	/**
+	 * Callback invoked with the pipe that has become readable
+	 */
+	using callback_t = std::function< void(const NamedPipe &) >;
+	/**
+	 * Callback invoked once a watch is over. The status is Status::Ok if the handle has become ready,
+	 * Status::Timeout if the timeout has expired first and Status::Interrupted if the watch has been cancelled.
+	 */
+	using completion_t = std::function< void(Status) >;
+
+	Reactor();
+	~Reactor();
+
+	Reactor(const Reactor &) = delete;
+	Reactor &operator=(const Reactor &) = delete;
+
+	/**
+	 * Registers a pipe with this reactor. This function is thread-safe and may also be called from within a
+	 * callback.
+	 *
+	 * @param pipe The pipe to wait on. It has to stay alive until it has been removed from this reactor again.
+	 * @param callback The function to invoke whenever the pipe has content available
+	 *
+	 * @throws PipeException If the pipe can't be waited on (e.g. because it has been registered already)
+	 */
+	void add(const NamedPipe &pipe, callback_t callback);
+
+	/**
+	 * Unregisters a pipe from this reactor. Once this function returns, the pipe's callback is not running anymore
+	 * (unless this function is called from within a callback) and won't be invoked again. This function is
+	 * thread-safe.
+	 *
+	 * @param pipe The pipe to stop waiting on
+	 */
+	void remove(const NamedPipe &pipe);
+
+	/**
+	 * Waits for the given handle to become ready once, without blocking the calling thread. This is the building
+	 * block for asynchronous operations (see NamedPipe::async_read and PipeWriter::async_write). This function is
+	 * thread-safe and may also be called from within a callback.
+	 *
+	 * @param handle The handle to wait for or -1 to only wait for the timeout to expire. The handle only has to stay
+	 * open until this function returns.
+	 * @param events The poll() events to wait for (POLLIN and/or POLLOUT)
+	 * @param timeout How long to wait at most
+	 * @param stopToken A token via which the watch can be cancelled
+	 * @param completion The function to invoke (on the thread running the reactor) once the watch is over
+	 *
+	 * @note Watches that are still pending when the reactor is destroyed are discarded without invoking their
+	 * completions
+	 */
+	void watch(int handle, short events, std::chrono::milliseconds timeout, const StopToken &stopToken,
+			   completion_t completion);
+
+	/**
+	 * @returns The amount of registered pipes
+	 */
+	[[nodiscard]] std::size_t size() const;
+
+	/**
+	 * Waits for content on the registered pipes and dispatches it to the respective callbacks until stop() is
+	 * called. Only a single thread may run the reactor at a time.
+	 */
+	void run();
+
+	/**
+	 * Waits for content on the registered pipes once and dispatches it to the respective callbacks
+	 *
+	 * @param timeout How long to wait for any pipe to become readable
+	 * @returns The amount of callbacks that have been invoked
+	 *
+	 * @note If a callback or completion throws, the exception is propagated right away. Completions that haven't
+	 * been invoked yet are invoked by the next run.
+	 */
+	std::size_t run_once(std::chrono::milliseconds timeout = std::chrono::milliseconds{
+							 (std::numeric_limits< unsigned int >::max)() });
+
+	/**
+	 * Makes the reactor stop: An ongoing run() returns as soon as the callbacks that are currently being invoked
+	 * have finished. All subsequent runs return right away (without invoking any callbacks or completions). This
+	 * function is thread-safe.
+	 */
+	void stop();
+
+	/**
+	 * @returns Whether stop() has been called
+	 */
+	[[nodiscard]] bool stopped() const noexcept;
+
+private:
+	struct Entry {
+		Entry(const NamedPipe *readyPipe, callback_t readyCallback)
+			: pipe(readyPipe), callback(std::move(readyCallback)) {}
+
+		const NamedPipe *pipe;
+		callback_t callback;
+		std::atomic_bool removed = false;
+	};
+
+	/**
+	 * The registered pipes by their reading handles. Entries are shared with an ongoing dispatch, so that they can be
+	 * removed while their callback is running.
+	 */
+	std::map< int, std::shared_ptr< Entry > > m_entries;
+	mutable std::mutex m_mutex;
+	/**
+	 * Held while callbacks are being dispatched
+	 */
+	std::mutex m_dispatchMutex;
+	std::atomic< std::thread::id > m_dispatchThread;
+	struct Watch;
+	using clock = std::chrono::steady_clock;
+
+	/**
+	 * Pending watches by their IDs
+	 */
+	std::map< std::uint64_t, std::unique_ptr< Watch > > m_watches;
+	/**
+	 * The IDs of all pending watches that have a timeout, ordered by when they expire
+	 */
+	std::multimap< clock::time_point, std::uint64_t > m_timers;
+	std::uint64_t m_nextWatchId = 0;
+	std::atomic_bool m_stopped  = false;
+	/**
+	 * Event that wakes up an ongoing wait, either because the reactor is stopped or because the wait has to be
+	 * adapted to new registrations
+	 */
+	std::unique_ptr< WakeupEvent > m_wakeup;
+	/**
+	 * The handle of the epoll instance (-1 where epoll is not available)
+	 */
+	int m_pollHandle = -1;
+	/**
+	 * Entries that are ready to be dispatched (kept as a member to reuse its memory)
+	 */
+	std::vector< std::shared_ptr< Entry > > m_ready;
+	/**
+	 * Completions of watches that are over and have to be invoked
+	 */
+	std::vector< std::pair< completion_t, Status > > m_completions;
+
+	/**
+	 * Blocks until any registered pipe becomes readable or any watch is over and collects the ready entries in
+	 * m_ready and the completions in m_completions
+	 *
+	 * @returns Whether the reactor has been stopped while waiting
+	 */
+	bool waitForReady(std::chrono::milliseconds timeout);
+	/**
+	 * @returns How long to wait for events (in poll() format), taking the pending watches' timeouts and left over
+	 * completions into account. The caller has to hold m_mutex.
+	 */
+	int waitTime(const Deadline &deadline) const;
+	/**
+	 * Handles an event reported for the handle with the given tag. The caller has to hold m_mutex.
+	 */
+	void handleEvent(std::uint64_t tag);
+	/**
+	 * Ends the given watch and schedules its completion. The caller has to hold m_mutex.
+	 */
+	void finishWatch(std::uint64_t id, Status status);
+	/**
+	 * Finishes all watches whose timeout has expired. The caller has to hold m_mutex.
+	 */
+	void expireWatches();
+};
+
+} // namespace npipe
+
+#endif // PIPE_PLATFORM_UNIX
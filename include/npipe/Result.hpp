@@ -0,0 +1,89 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// source tree or at
+// <https://github.com/Krzmbrzl/NamedPipe/blob/main/LICENSE>.
+
+#pragma once
+
+#include <cstdint>
+
+namespace npipe {
+
+/**
+ * The outcome of a pipe operation
+ */
+enum class Status : std::uint8_t {
+	/**
+	 * The operation completed successfully
+	 */
+	Ok,
+	/**
+	 * The operation didn't complete before its timeout expired
+	 */
+	Timeout,
+	/**
+	 * The operation has been interrupted (see NamedPipe::interrupt and StopToken)
+	 */
+	Interrupted,
+	/**
+	 * The pipe has been closed (e.g. it has been destroyed) or there is no reader that could be reached
+	 */
+	Closed,
+	/**
+	 * The operation failed. The associated error code holds the cause.
+	 */
+	Error,
+};
+
+#ifdef PIPE_PLATFORM_WINDOWS
+/**
+ * The type of error codes reported by the OS (DWORD on Windows)
+ */
+using ErrorCode = unsigned long;
+#else
+/**
+ * The type of error codes reported by the OS (errno on Posix systems)
+ */
+using ErrorCode = int;
+#endif
+
+/**
+ * Result of a non-throwing pipe operation. Next to the operation's status, it carries a value (e.g. the amount of
+ * transferred bytes), which is also meaningful if the operation didn't complete successfully.
+ *
+ * @tparam value_t The type of the carried value
+ */
+template< typename value_t > class Result {
+public:
+	constexpr Result(Status status, value_t value = value_t(), ErrorCode errorCode = 0) noexcept
+		: m_value(value), m_errorCode(errorCode), m_status(status) {}
+
+	/**
+	 * @returns The status of the operation
+	 */
+	[[nodiscard]] constexpr Status status() const noexcept { return m_status; }
+
+	/**
+	 * @returns The error code reported by the OS. Only meaningful if the status is Status::Error or Status::Closed.
+	 */
+	[[nodiscard]] constexpr ErrorCode errorCode() const noexcept { return m_errorCode; }
+
+	/**
+	 * @returns The carried value
+	 */
+	[[nodiscard]] constexpr const value_t &value() const noexcept { return m_value; }
+
+	/**
+	 * @returns Whether the operation completed successfully
+	 */
+	[[nodiscard]] constexpr bool ok() const noexcept { return m_status == Status::Ok; }
+
+	constexpr explicit operator bool() const noexcept { return ok(); }
+
+private:
+	value_t m_value;
+	ErrorCode m_errorCode;
+	Status m_status;
+};
+
+} // namespace npipe
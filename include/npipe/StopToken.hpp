@@ -0,0 +1,80 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// source tree or at
+// <https://github.com/Krzmbrzl/NamedPipe/blob/main/LICENSE>.
+
+#pragma once
+
+#include <memory>
+
+namespace npipe {
+
+struct StopState;
+class StopToken;
+
+/**
+ * Allows to cancel operations that have been handed a StopToken obtained from this source. Cancellation takes effect
+ * immediately, even if the operation is currently waiting for the pipe.
+ * This is modeled after C++20's std::stop_source.
+ */
+class StopSource {
+public:
+	StopSource();
+
+	/**
+	 * @returns A token associated with this source
+	 */
+	[[nodiscard]] StopToken get_token() const noexcept;
+
+	/**
+	 * Requests all operations associated with this source to stop. Once requested, this can't be undone.
+	 *
+	 * @returns Whether this call has made the request (as opposed to it having been made before)
+	 */
+	bool request_stop() noexcept;
+
+	/**
+	 * @returns Whether a stop has been requested on this source
+	 */
+	[[nodiscard]] bool stop_requested() const noexcept;
+
+private:
+	std::shared_ptr< StopState > m_state;
+};
+
+/**
+ * A token via which an operation can find out whether it is supposed to stop. A default-constructed token is never
+ * stopped.
+ * This is modeled after C++20's std::stop_token.
+ */
+class StopToken {
+public:
+	StopToken() noexcept = default;
+
+	/**
+	 * @returns Whether a stop has been requested on the associated source
+	 */
+	[[nodiscard]] bool stop_requested() const noexcept;
+
+	/**
+	 * @returns Whether this token is associated with a source that can request a stop at all
+	 */
+	[[nodiscard]] bool stop_possible() const noexcept;
+
+#ifdef PIPE_PLATFORM_UNIX
+	/**
+	 * @returns A file descriptor that becomes readable once a stop has been requested or -1 if this token can't be
+	 * stopped. This can be used to wait for a stop request via poll() and friends.
+	 */
+	[[nodiscard]] int native_handle() const noexcept;
+#endif
+
+private:
+	friend class StopSource;
+
+	explicit StopToken(std::shared_ptr< StopState > state) noexcept;
+
+	std::shared_ptr< StopState > m_state;
+};
+
+} // namespace npipe
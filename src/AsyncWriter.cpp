@@ -0,0 +1,261 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// source tree or at
+// <https://github.com/Krzmbrzl/NamedPipe/blob/main/LICENSE>.
+
+#include "npipe/AsyncWriter.hpp"
+#include "npipe/Framing.hpp"
+#include "npipe/FramingException.hpp"
+#include "npipe/PipeException.hpp"
+#include "npipe/TimeoutException.hpp"
+
+#include "MpscRing.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace npipe {
+
+struct AsyncWriter::Write {
+	std::filesystem::path pipePath;
+	/**
+	 * The bytes to write, including the frame header in framed mode
+	 */
+	std::vector< std::byte > message;
+	std::chrono::milliseconds timeout;
+	completion_t completion;
+};
+
+/**
+ * Writes the given message as-is. The first attempt doesn't wait, in case the reader of an existing connection has
+ * gone away - the writer would wait for a new reader otherwise.
+ *
+ * @returns The outcome of the write (see PipeWriter::try_write)
+ */
+static Result< std::size_t > writeRaw(PipeWriter &writer, const std::byte *message, std::size_t messageSize,
+									  std::chrono::milliseconds timeout) noexcept {
+	Result< std::size_t > result = writer.try_write(message, messageSize, std::chrono::milliseconds(0));
+
+	if (result.status() == Status::Timeout) {
+		// There is a reader, it just hasn't made enough room yet
+		const std::size_t written        = result.value();
+		const Result< std::size_t > rest = writer.try_write(message + written, messageSize - written, timeout);
+
+		result = Result< std::size_t >(rest.status(), written + rest.value(), rest.errorCode());
+	}
+
+	return result;
+}
+
+/**
+ * Writes the given message as a single frame (see PipeWriter::write_message), so that it either arrives as a whole or
+ * the connection gets closed. Like writeRaw, the first attempt doesn't wait.
+ *
+ * @returns The outcome of the write, carrying the amount of payload bytes that have been written
+ */
+static Result< std::size_t > writeFrame(PipeWriter &writer, const std::byte *message, std::size_t messageSize,
+										std::chrono::milliseconds timeout) noexcept {
+	for (const std::chrono::milliseconds attempt : { std::chrono::milliseconds(0), timeout }) {
+		try {
+			writer.write_message(message, messageSize, attempt);
+
+			return Result< std::size_t >(Status::Ok, messageSize);
+		} catch (const TimeoutException &) {
+			if (!writer.isConnected()) {
+				// Either the reader has gone away or the frame couldn't be finished
+				return Result< std::size_t >(Status::Closed);
+			}
+		} catch (const PipeException< ErrorCode > &e) {
+			return Result< std::size_t >(Status::Error, 0, e.errorCode());
+		} catch (const Exception &) {
+			return Result< std::size_t >(Status::Error);
+		}
+	}
+
+	// There is a reader, but it didn't make room for the frame in time. Nothing of the frame has been written.
+	return Result< std::size_t >(Status::Timeout);
+}
+
+AsyncWriter::AsyncWriter(AsyncWriterOptions options)
+	: m_options(options), m_ring(std::make_unique< MpscRing< Write > >(options.capacity)) {
+	m_thread = std::thread(&AsyncWriter::runThread, this);
+}
+
+AsyncWriter::~AsyncWriter() {
+	m_stop = true;
+	wakeThread();
+
+	m_thread.join();
+}
+
+bool AsyncWriter::write_async(const std::filesystem::path &pipePath, const std::byte *message,
+							  std::size_t messageSize, completion_t completion, std::chrono::milliseconds timeout) {
+	assert(message || messageSize == 0);
+
+	if (m_options.framed && messageSize > FrameHeader::maxLength) {
+		throw FramingException();
+	}
+
+	const auto fill = [&](Write &write) {
+		// The slot's memory is reused, so this only allocates until the slots have grown to typical message sizes
+		write.pipePath = pipePath;
+		write.message.assign(message, message + messageSize);
+		write.timeout    = timeout;
+		write.completion = std::move(completion);
+	};
+
+	if (!m_ring->try_push(fill)) {
+		return false;
+	}
+
+	if (m_idle.load()) {
+		wakeThread();
+	}
+
+	return true;
+}
+
+std::future< Result< std::size_t > > AsyncWriter::write_async(const std::filesystem::path &pipePath,
+															  const std::byte *message, std::size_t messageSize,
+															  std::chrono::milliseconds timeout) {
+	// std::function requires copyable targets, which a promise is not
+	auto promise = std::make_shared< std::promise< Result< std::size_t > > >();
+	std::future< Result< std::size_t > > future = promise->get_future();
+
+	const bool queued = write_async(
+		pipePath, message, messageSize,
+		[promise](Result< std::size_t > result) { promise->set_value(result); }, timeout);
+
+	if (!queued) {
+		promise->set_value(Result< std::size_t >(Status::Timeout));
+	}
+
+	return future;
+}
+
+std::size_t AsyncWriter::pending() const noexcept {
+	return m_ring->writePosition() - m_ring->readPosition();
+}
+
+void AsyncWriter::wakeThread() {
+	// Taking the lock makes sure the background thread can't miss the notification in between checking for work and
+	// going to sleep
+	std::lock_guard< std::mutex > lock(m_mutex);
+	m_wakeup.notify_one();
+}
+
+bool AsyncWriter::hasWork() const noexcept {
+	return m_ring->peek() != nullptr;
+}
+
+void AsyncWriter::process() {
+	auto *slot   = m_ring->peek();
+	Write &write = slot->value;
+
+	completion_t completion = std::move(write.completion);
+	write.completion        = nullptr;
+
+	Result< std::size_t > result(Status::Ok);
+
+	if (slot->discarded) {
+		completion = nullptr;
+	} else if (m_options.framed || !write.message.empty()) {
+		result = send(write.pipePath, write.message.data(), write.message.size(), write.timeout);
+	}
+
+	// Hand the slot back to the writers before reporting, so that completions may queue further writes
+	write.message.clear();
+	m_ring->pop();
+
+	if (completion) {
+		completion(result);
+	}
+}
+
+Result< std::size_t > AsyncWriter::send(const std::filesystem::path &pipePath, const std::byte *message,
+										std::size_t messageSize, std::chrono::milliseconds timeout) {
+	auto it = m_connections.find(pipePath);
+	if (it == m_connections.end()) {
+		try {
+			it = m_connections.emplace(pipePath, Connection{ PipeWriter(pipePath), {} }).first;
+		} catch (const std::bad_alloc &) {
+			return Result< std::size_t >(Status::Error, 0, ENOMEM);
+		}
+	}
+
+	Connection &connection = it->second;
+	connection.lastUsed    = std::chrono::steady_clock::now();
+	m_nextEviction         = (std::min)(m_nextEviction, connection.lastUsed + m_options.idleTimeout);
+
+	// Waiting for a reader would hold up the writes to all other pipes, so pipes without one fail right away
+	Result< std::size_t > result(Status::Closed);
+	if (connection.writer.try_connect()) {
+		result = m_options.framed ? writeFrame(connection.writer, message, messageSize, timeout)
+								  : writeRaw(connection.writer, message, messageSize, timeout);
+	}
+
+	// The rest of a partially written message must not be replaced by the next message
+	const bool partial = result.status() == Status::Timeout && result.value() > 0;
+
+	if (result.status() == Status::Closed || result.status() == Status::Error || partial
+		|| !connection.writer.isConnected()) {
+		m_connections.erase(it);
+	}
+
+	return result;
+}
+
+void AsyncWriter::evictIdle() {
+	const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+	if (now < m_nextEviction) {
+		return;
+	}
+
+	m_nextEviction = std::chrono::steady_clock::time_point::max();
+
+	for (auto it = m_connections.begin(); it != m_connections.end();) {
+		const std::chrono::steady_clock::time_point idleSince = it->second.lastUsed + m_options.idleTimeout;
+
+		if (idleSince <= now) {
+			it = m_connections.erase(it);
+		} else {
+			m_nextEviction = (std::min)(m_nextEviction, idleSince);
+			++it;
+		}
+	}
+}
+
+void AsyncWriter::runThread() {
+	while (true) {
+		evictIdle();
+
+		if (!hasWork()) {
+			if (m_stop) {
+				return;
+			}
+
+			std::unique_lock< std::mutex > lock(m_mutex);
+			m_idle = true;
+			// Writers check whether we are idle after having published their write, so that either they see us idle
+			// or we see their write here
+			const auto woken = [&]() { return m_stop || hasWork(); };
+			if (m_nextEviction == std::chrono::steady_clock::time_point::max()) {
+				m_wakeup.wait(lock, woken);
+			} else {
+				m_wakeup.wait_until(lock, m_nextEviction, woken);
+			}
+			m_idle = false;
+
+			continue;
+		}
+
+		process();
+	}
+}
+
+} // namespace npipe
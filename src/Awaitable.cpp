@@ -0,0 +1,173 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// source tree or at
+// <https://github.com/Krzmbrzl/NamedPipe/blob/main/LICENSE>.
+
+#include "npipe/Awaitable.hpp"
+#include "npipe/InterruptException.hpp"
+#include "npipe/NamedPipe.hpp"
+#include "npipe/PipeException.hpp"
+#include "npipe/PipeWriter.hpp"
+#include "npipe/Reactor.hpp"
+#include "npipe/TimeoutException.hpp"
+
+#include "Deadline.hpp"
+#include "PosixUtils.hpp"
+
+#include <poll.h>
+
+#include <algorithm>
+#include <cassert>
+#include <utility>
+
+namespace npipe {
+
+/**
+ * How often to check whether a pipe that has no reader has got one in the meantime
+ */
+constexpr std::chrono::milliseconds READER_POLL_INTERVAL(1);
+
+ReadAwaitable::ReadAwaitable(const NamedPipe &pipe, Reactor &reactor, std::chrono::milliseconds timeout,
+							 StopToken stopToken)
+	: m_pipe(pipe), m_reactor(reactor), m_timeout(timeout), m_stopToken(std::move(stopToken)) {
+}
+
+bool ReadAwaitable::await_ready() const noexcept {
+	return availableBytes(m_pipe.m_readHandle).value_or(0) > 0;
+}
+
+void ReadAwaitable::suspend(std::function< void() > resume) {
+	m_reactor.watch(m_pipe.m_readHandle, POLLIN, m_timeout, m_stopToken,
+					[this, resume = std::move(resume)](Status status) {
+						m_status = status;
+						resume();
+					});
+}
+
+std::vector< std::byte > ReadAwaitable::await_resume() {
+	switch (m_status) {
+		case Status::Timeout:
+			throw TimeoutException();
+		case Status::Interrupted:
+			throw InterruptException();
+		default:
+			break;
+	}
+
+	// The content is there already, so this doesn't block
+	return m_pipe.read_blocking(std::chrono::milliseconds(0), m_stopToken);
+}
+
+
+WriteAwaitable::WriteAwaitable(PipeWriter &writer, Reactor &reactor, const std::byte *message,
+							   std::size_t messageSize, std::chrono::milliseconds timeout, StopToken stopToken)
+	: m_writer(writer), m_reactor(reactor), m_message(message), m_messageSize(messageSize),
+	  m_deadline(Deadline(timeout).get()), m_stopToken(std::move(stopToken)) {
+	assert(message);
+}
+
+bool WriteAwaitable::await_ready() {
+	return advance();
+}
+
+void WriteAwaitable::suspend(std::function< void() > resume) {
+	m_resume = std::move(resume);
+
+	wait();
+}
+
+void WriteAwaitable::await_resume() const {
+	switch (m_status) {
+		case Status::Ok:
+			return;
+		case Status::Timeout:
+		case Status::Closed:
+			throw TimeoutException();
+		case Status::Interrupted:
+			throw InterruptException();
+		case Status::Error:
+			throw PipeException< int >(m_errorCode, "Write");
+	}
+}
+
+bool WriteAwaitable::advance() {
+	while (m_written < m_messageSize) {
+		if (m_stopToken.stop_requested()) {
+			m_status = Status::Interrupted;
+			return true;
+		}
+
+		// Write whatever fits into the pipe right now
+		const Result< std::size_t > result =
+			m_writer.try_write(m_message + m_written, m_messageSize - m_written, std::chrono::milliseconds(0));
+		m_written += result.value();
+
+		switch (result.status()) {
+			case Status::Ok:
+				continue;
+			case Status::Timeout:
+				// The pipe is full
+				m_waitForReader = false;
+				break;
+			case Status::Closed:
+				// There is no reader (yet)
+				m_waitForReader = true;
+				break;
+			case Status::Interrupted:
+			case Status::Error:
+				m_status    = result.status();
+				m_errorCode = result.errorCode();
+				return true;
+		}
+
+		if (clock::now() >= m_deadline) {
+			m_status = Status::Timeout;
+			return true;
+		}
+
+		return false;
+	}
+
+	m_status = Status::Ok;
+	return true;
+}
+
+void WriteAwaitable::wait() {
+	const clock::time_point now = clock::now();
+	const std::chrono::milliseconds remaining =
+		m_deadline > now ? std::chrono::ceil< std::chrono::milliseconds >(m_deadline - now)
+						 : std::chrono::milliseconds(0);
+
+	auto completion = [this](Status status) { onWatchCompleted(status); };
+
+	if (m_waitForReader) {
+		// There is nothing to wait on until the pipe has a reader, so check back periodically
+		m_reactor.watch(-1, 0, (std::min)(READER_POLL_INTERVAL, remaining), m_stopToken, std::move(completion));
+	} else {
+		m_reactor.watch(m_writer.native_handle(), POLLOUT, remaining, m_stopToken, std::move(completion));
+	}
+}
+
+void WriteAwaitable::onWatchCompleted(Status status) {
+	if (status == Status::Interrupted) {
+		m_status = status;
+		m_resume();
+		return;
+	}
+
+	// Either the pipe has room again or it is time to check again (or to give up)
+	if (advance()) {
+		m_resume();
+		return;
+	}
+
+	try {
+		wait();
+	} catch (const PipeException< int > &exception) {
+		m_status    = Status::Error;
+		m_errorCode = exception.errorCode();
+		m_resume();
+	}
+}
+
+} // namespace npipe
@@ -0,0 +1,155 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// source tree or at
+// <https://github.com/Krzmbrzl/NamedPipe/blob/main/LICENSE>.
+
+#include "npipe/BufferPool.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+namespace npipe {
+
+/**
+ * @returns The index of the size class for buffers of the given size
+ */
+static std::size_t sizeClassIndex(std::size_t size) noexcept {
+	std::size_t index     = 0;
+	std::size_t classSize = BufferPool::minBufferSize;
+
+	while (classSize < size) {
+		classSize *= 2;
+		++index;
+	}
+
+	return index;
+}
+
+constexpr std::size_t SIZE_CLASS_COUNT = [] {
+	std::size_t count = 1;
+	for (std::size_t size = BufferPool::minBufferSize; size < BufferPool::maxBufferSize; size *= 2) {
+		++count;
+	}
+
+	return count;
+}();
+
+
+Message::Message(BufferPool *pool, std::byte *buffer, std::size_t size, std::size_t capacity) noexcept
+	: m_pool(pool), m_buffer(buffer), m_size(size), m_capacity(capacity) {
+}
+
+Message::~Message() {
+	release();
+}
+
+Message::Message(Message &&other) noexcept
+	: m_pool(other.m_pool), m_buffer(other.m_buffer), m_size(other.m_size), m_capacity(other.m_capacity) {
+	other.m_pool     = nullptr;
+	other.m_buffer   = nullptr;
+	other.m_size     = 0;
+	other.m_capacity = 0;
+}
+
+Message &Message::operator=(Message &&other) noexcept {
+	if (this != &other) {
+		release();
+
+		m_pool     = other.m_pool;
+		m_buffer   = other.m_buffer;
+		m_size     = other.m_size;
+		m_capacity = other.m_capacity;
+
+		other.m_pool     = nullptr;
+		other.m_buffer   = nullptr;
+		other.m_size     = 0;
+		other.m_capacity = 0;
+	}
+
+	return *this;
+}
+
+void Message::resize(std::size_t size) {
+	if (size > m_capacity) {
+		// Messages that don't belong to any pool can't grow
+		assert(m_pool);
+
+		Message bigger = m_pool->acquire((std::max)(size, 2 * m_capacity));
+		std::memcpy(bigger.data(), m_buffer, m_size);
+
+		*this = std::move(bigger);
+	}
+
+	m_size = size;
+}
+
+void Message::release() noexcept {
+	if (m_buffer) {
+		m_pool->release(m_buffer, m_capacity);
+
+		m_buffer   = nullptr;
+		m_size     = 0;
+		m_capacity = 0;
+	}
+}
+
+
+BufferPool::BufferPool(std::size_t buffersPerClass)
+	: m_buffersPerClass(buffersPerClass),
+	  m_slots(std::make_unique< std::atomic< std::byte * >[] >(SIZE_CLASS_COUNT * buffersPerClass)) {
+	for (std::size_t i = 0; i < SIZE_CLASS_COUNT * m_buffersPerClass; ++i) {
+		m_slots[i].store(nullptr, std::memory_order_relaxed);
+	}
+}
+
+BufferPool::~BufferPool() {
+	for (std::size_t i = 0; i < SIZE_CLASS_COUNT * m_buffersPerClass; ++i) {
+		delete[] m_slots[i].load(std::memory_order_relaxed);
+	}
+}
+
+Message BufferPool::acquire(std::size_t size) {
+	if (size > maxBufferSize) {
+		return Message(this, new std::byte[size], size, size);
+	}
+
+	const std::size_t classIndex = sizeClassIndex(size);
+	const std::size_t capacity   = minBufferSize << classIndex;
+
+	std::atomic< std::byte * > *slots = m_slots.get() + classIndex * m_buffersPerClass;
+	for (std::size_t i = 0; i < m_buffersPerClass; ++i) {
+		// Only attempt to take the buffer (which requires exclusive access to the cache line) if there is one
+		if (slots[i].load(std::memory_order_relaxed)) {
+			std::byte *buffer = slots[i].exchange(nullptr, std::memory_order_acquire);
+
+			if (buffer) {
+				return Message(this, buffer, size, capacity);
+			}
+		}
+	}
+
+	// There is no unused buffer in this size class
+	return Message(this, new std::byte[capacity], size, capacity);
+}
+
+void BufferPool::release(std::byte *buffer, std::size_t capacity) noexcept {
+	if (capacity <= maxBufferSize) {
+		std::atomic< std::byte * > *slots = m_slots.get() + sizeClassIndex(capacity) * m_buffersPerClass;
+
+		for (std::size_t i = 0; i < m_buffersPerClass; ++i) {
+			std::byte *expected = nullptr;
+
+			if (!slots[i].load(std::memory_order_relaxed)
+				&& slots[i].compare_exchange_strong(expected, buffer, std::memory_order_release,
+													std::memory_order_relaxed)) {
+				return;
+			}
+		}
+	}
+
+	// The buffer is either too big to be kept or the size class has enough unused buffers already
+	delete[] buffer;
+}
+
+} // namespace npipe
@@ -0,0 +1,111 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// source tree or at
+// <https://github.com/Krzmbrzl/NamedPipe/blob/main/LICENSE>.
+
+#include "CapacityController.hpp"
+#include "PosixUtils.hpp"
+
+#include <algorithm>
+#include <optional>
+
+namespace npipe {
+
+CapacityController::CapacityController(int handle, const AdaptiveCapacityOptions &options)
+	: m_handle(handle), m_options(options) {
+	if (m_options.maxCapacity == 0) {
+		m_options.maxCapacity = maxPipeCapacity();
+	}
+
+	m_options.minCapacity = std::min(m_options.minCapacity, m_options.maxCapacity);
+	m_capacity            = pipeCapacity(m_handle).value_or(0);
+}
+
+void CapacityController::sample(std::size_t fillLevel) noexcept {
+	std::lock_guard< std::mutex > guard(m_mutex);
+
+	m_peakFillLevel = std::max(m_peakFillLevel, fillLevel);
+
+	if (m_capacity == 0) {
+		// Without knowing the current capacity, there's no way of telling how full the pipe is
+		return;
+	}
+
+	const clock::time_point now = clock::now();
+	const double fillRatio      = static_cast< double >(fillLevel) / static_cast< double >(m_capacity);
+
+	if (fillRatio > m_options.idleThreshold) {
+		m_lastActive = now;
+	}
+
+	if (fillRatio >= m_options.growThreshold) {
+		if (++m_busySamples >= m_options.growAfter && m_capacity < m_options.maxCapacity) {
+			m_busySamples = 0;
+
+			resize(std::min(m_capacity * 2, m_options.maxCapacity), m_growCount);
+		}
+
+		return;
+	}
+
+	m_busySamples = 0;
+
+	shrinkIfIdle(now);
+}
+
+void CapacityController::checkIdle(std::size_t fillLevel) noexcept {
+	std::lock_guard< std::mutex > guard(m_mutex);
+
+	if (m_capacity == 0) {
+		return;
+	}
+
+	const clock::time_point now = clock::now();
+
+	if (static_cast< double >(fillLevel) / static_cast< double >(m_capacity) > m_options.idleThreshold) {
+		// Content that is waiting to be read means the pipe isn't idle
+		m_lastActive = now;
+		return;
+	}
+
+	shrinkIfIdle(now);
+}
+
+std::chrono::milliseconds CapacityController::idleCheckInterval() const noexcept {
+	// Never busy-loop, even if shrinking is supposed to happen right away
+	return std::max(m_options.shrinkAfter, std::chrono::milliseconds(1));
+}
+
+void CapacityController::shrinkIfIdle(clock::time_point now) noexcept {
+	if (now - m_lastActive >= m_options.shrinkAfter && m_capacity > m_options.minCapacity) {
+		// Space out subsequent shrinking steps by the same delay
+		m_lastActive = now;
+
+		resize(std::max(m_capacity / 2, m_options.minCapacity), m_shrinkCount);
+	}
+}
+
+void CapacityController::collect(CapacityMetrics &metrics) const {
+	std::lock_guard< std::mutex > guard(m_mutex);
+
+	metrics.peakFillLevel     = m_peakFillLevel;
+	metrics.growCount         = m_growCount;
+	metrics.shrinkCount       = m_shrinkCount;
+	metrics.failedResizeCount = m_failedCount;
+}
+
+void CapacityController::resize(std::size_t capacity, std::uint64_t &counter) noexcept {
+	const std::optional< std::size_t > resulting = resizePipe(m_handle, capacity);
+
+	if (!resulting) {
+		// Either the per-user limit has been reached or (when shrinking) the content doesn't fit into the smaller
+		// buffer. Either way, we'll try again once the conditions call for it again.
+		++m_failedCount;
+		return;
+	}
+
+	m_capacity = *resulting;
+	++counter;
+}
+
+} // namespace npipe
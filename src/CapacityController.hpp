@@ -0,0 +1,75 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// source tree or at
+// <https://github.com/Krzmbrzl/NamedPipe/blob/main/LICENSE>.
+
+#pragma once
+
+#include "npipe/PipeCapacity.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+namespace npipe {
+
+/**
+ * Grows and shrinks a pipe's kernel buffer based on how full the pipe is whenever its reader gets to it
+ */
+class CapacityController {
+public:
+	/**
+	 * @param handle A handle to the pipe to manage. It has to stay open for as long as this object is in use.
+	 * @param options The settings to use
+	 */
+	CapacityController(int handle, const AdaptiveCapacityOptions &options);
+
+	/**
+	 * Records the amount of bytes a reader has found waiting in the pipe and resizes the pipe if that is called for.
+	 * Failed resizes are recorded in the metrics only.
+	 *
+	 * @param fillLevel The amount of bytes waiting in the pipe
+	 */
+	void sample(std::size_t fillLevel) noexcept;
+
+	/**
+	 * Shrinks the pipe if it has been idle for long enough. As opposed to sample(), this doesn't count as a read, so
+	 * it can be called whenever convenient (e.g. while the reader is waiting for content).
+	 *
+	 * @param fillLevel The amount of bytes waiting in the pipe
+	 */
+	void checkIdle(std::size_t fillLevel) noexcept;
+
+	/**
+	 * @returns How often checkIdle() should be called for the pipe to be shrunk in time
+	 */
+	[[nodiscard]] std::chrono::milliseconds idleCheckInterval() const noexcept;
+
+	/**
+	 * @param metrics The metrics to fill in the statistics gathered by this controller into
+	 */
+	void collect(CapacityMetrics &metrics) const;
+
+private:
+	using clock = std::chrono::steady_clock;
+
+	void resize(std::size_t capacity, std::uint64_t &counter) noexcept;
+	/**
+	 * Halves the capacity if the pipe has been idle for long enough. The mutex has to be held by the caller.
+	 */
+	void shrinkIfIdle(clock::time_point now) noexcept;
+
+	mutable std::mutex m_mutex;
+	int m_handle;
+	AdaptiveCapacityOptions m_options;
+	std::size_t m_capacity         = 0;
+	std::size_t m_busySamples      = 0;
+	clock::time_point m_lastActive = clock::now();
+	std::size_t m_peakFillLevel    = 0;
+	std::uint64_t m_growCount      = 0;
+	std::uint64_t m_shrinkCount    = 0;
+	std::uint64_t m_failedCount    = 0;
+};
+
+} // namespace npipe
@@ -0,0 +1,244 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// source tree or at
+// <https://github.com/Krzmbrzl/NamedPipe/blob/main/LICENSE>.
+
+#include "npipe/CoalescingWriter.hpp"
+#include "npipe/Exception.hpp"
+#include "npipe/Framing.hpp"
+#include "npipe/FramingException.hpp"
+#include "npipe/TimeoutException.hpp"
+
+#include "MpscRing.hpp"
+
+#include <cassert>
+#include <cstdint>
+#include <utility>
+
+namespace npipe {
+
+CoalescingWriter::CoalescingWriter(std::filesystem::path pipePath, CoalescingWriterOptions options)
+	: m_options(options), m_writer(std::move(pipePath)),
+	  m_ring(std::make_unique< MpscRing< std::vector< std::byte > > >(options.capacity)) {
+	m_batch.reserve(m_ring->capacity());
+
+	m_flusher = std::thread(&CoalescingWriter::runFlusher, this);
+}
+
+CoalescingWriter::~CoalescingWriter() {
+	m_stop = true;
+	wakeFlusher();
+
+	m_flusher.join();
+}
+
+std::filesystem::path CoalescingWriter::getPath() const noexcept {
+	return m_writer.getPath();
+}
+
+void CoalescingWriter::write(const std::byte *message, std::size_t messageSize, std::chrono::milliseconds timeout) {
+	assert(message || messageSize == 0);
+
+	if (m_options.framed && messageSize > FrameHeader::maxLength) {
+		// Such a message would make every attempt at writing the buffered messages fail
+		throw FramingException();
+	}
+
+	const auto deadline = std::chrono::steady_clock::now() + timeout;
+
+	// The slot's memory is reused, so this only allocates until the slots have grown to typical message sizes
+	const auto fill = [&](std::vector< std::byte > &slot) { slot.assign(message, message + messageSize); };
+
+	while (!m_ring->try_push(fill)) {
+		// The buffer is full -> wait for the flusher to make room. It hands back slots while holding the mutex, so
+		// checking for room under the mutex can't miss the notification.
+		std::unique_lock< std::mutex > lock(m_mutex);
+		m_wakeup.notify_one();
+
+		const bool hasRoom = m_drained.wait_until(lock, deadline, [&]() {
+			return m_ring->writePosition() - m_ring->readPosition() < m_ring->capacity();
+		});
+
+		if (!hasRoom) {
+			throw TimeoutException();
+		}
+	}
+
+	const std::size_t bufferedBytes = m_bufferedBytes.fetch_add(messageSize) + messageSize;
+	const bool reachedThreshold =
+		bufferedBytes >= m_options.flushThreshold && bufferedBytes - messageSize < m_options.flushThreshold;
+
+	if (reachedThreshold || m_idle.load()) {
+		wakeFlusher();
+	}
+}
+
+void CoalescingWriter::flush(std::chrono::milliseconds timeout) {
+	const std::size_t target = m_ring->writePosition();
+
+	++m_flushRequests;
+	wakeFlusher();
+
+	std::unique_lock< std::mutex > lock(m_mutex);
+	const bool drained = m_drained.wait_for(lock, timeout, [&]() {
+		return static_cast< std::ptrdiff_t >(m_ring->readPosition() - target) >= 0;
+	});
+
+	--m_flushRequests;
+
+	if (!drained) {
+		throw TimeoutException();
+	}
+}
+
+void CoalescingWriter::wakeFlusher() {
+	// Taking the lock makes sure the flusher can't miss the notification in between checking for work and going to
+	// sleep
+	std::lock_guard< std::mutex > lock(m_mutex);
+	m_wakeup.notify_one();
+}
+
+std::size_t CoalescingWriter::readyMessages(std::size_t &bytes) const noexcept {
+	std::size_t count = 0;
+	bytes             = 0;
+
+	while (const auto *slot = m_ring->peek(count)) {
+		if (slot->discarded && count > 0) {
+			// Discarded slots are dealt with on their own
+			break;
+		}
+
+		bytes += slot->value.size();
+		++count;
+	}
+
+	return count;
+}
+
+std::size_t CoalescingWriter::writeBatch(std::size_t count) {
+	std::size_t written = 0;
+
+	if (m_ring->peek()->discarded) {
+		written = 1;
+	} else {
+		m_batch.clear();
+		for (std::size_t i = 0; i < count; ++i) {
+			const std::vector< std::byte > &message = m_ring->peek(i)->value;
+			m_batch.push_back({ message.data(), message.size() });
+		}
+
+		if (m_options.framed) {
+			try {
+				// Frames are never written partially, so the messages that haven't been written can be sent as-is
+				written = m_writer.write_many(m_batch.data(), m_batch.size(), m_options.writeTimeout);
+			} catch (const FramingException &) {
+				// write() rejects messages that can't be framed, so this can't happen. Should it anyway, retrying
+				// would fail the same way forever, so the batch is dropped rather than wedging the buffer.
+				written = count;
+			} catch (const Exception &) {
+				// Most likely there is no reader at the moment. The messages are kept for the next attempt.
+			}
+		} else {
+			// Skip whatever a previous attempt managed to write of the oldest message already
+			m_batch.front().data += m_headOffset;
+			m_batch.front().size -= m_headOffset;
+
+			const Result< std::size_t > result =
+				m_writer.try_write_gather(m_batch.data(), m_batch.size(), m_options.writeTimeout);
+
+			// Resume exactly where this attempt has stopped, so that no byte is sent twice
+			std::size_t remaining = result.value();
+			while (written < count && remaining >= m_batch[written].size) {
+				remaining -= m_batch[written].size;
+				++written;
+			}
+
+			if (written > 0) {
+				m_headOffset = 0;
+			}
+			m_headOffset += remaining;
+		}
+	}
+
+	// Hand the written slots back to the writers
+	std::size_t writtenBytes = 0;
+	for (std::size_t i = 0; i < written; ++i) {
+		std::vector< std::byte > &message = m_ring->peek(i)->value;
+
+		writtenBytes += message.size();
+		message.clear();
+	}
+
+	m_bufferedBytes -= writtenBytes;
+
+	{
+		std::lock_guard< std::mutex > lock(m_mutex);
+		m_ring->pop(written);
+	}
+	m_drained.notify_all();
+
+	return written;
+}
+
+void CoalescingWriter::runFlusher() {
+	using clock = std::chrono::steady_clock;
+
+	// The point in time at which the currently buffered messages have to be written at the latest
+	clock::time_point batchDeadline = clock::time_point::max();
+
+	while (true) {
+		std::size_t bytes;
+		const std::size_t count = readyMessages(bytes);
+
+		if (count == 0) {
+			if (m_stop) {
+				return;
+			}
+
+			std::unique_lock< std::mutex > lock(m_mutex);
+			m_idle = true;
+			// Writers check whether we are idle after having published their message, so that either they see us
+			// idle or we see their message here
+			m_wakeup.wait(lock, [&]() {
+				std::size_t ignored;
+				return m_stop || readyMessages(ignored) > 0;
+			});
+			m_idle = false;
+
+			continue;
+		}
+
+		const bool flushNow = bytes >= m_options.flushThreshold || m_flushRequests > 0 || m_stop;
+
+		if (!flushNow) {
+			if (batchDeadline == clock::time_point::max()) {
+				batchDeadline = clock::now() + m_options.maxLatency;
+			}
+
+			if (clock::now() < batchDeadline) {
+				// Give other messages the chance to join the batch
+				std::unique_lock< std::mutex > lock(m_mutex);
+				m_wakeup.wait_until(lock, batchDeadline, [&]() {
+					return m_stop || m_flushRequests > 0 || m_bufferedBytes >= m_options.flushThreshold;
+				});
+
+				continue;
+			}
+		}
+
+		batchDeadline = clock::time_point::max();
+
+		if (writeBatch(count) == 0) {
+			if (m_stop) {
+				// The final attempt failed -> give up on the remaining messages
+				return;
+			}
+
+			// Don't hammer the pipe while it isn't usable
+			std::unique_lock< std::mutex > lock(m_mutex);
+			m_wakeup.wait_for(lock, m_options.writeTimeout, [&]() { return m_stop.load(); });
+		}
+	}
+}
+
+} // namespace npipe
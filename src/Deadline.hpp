@@ -0,0 +1,71 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// source tree or at
+// <https://github.com/Krzmbrzl/NamedPipe/blob/main/LICENSE>.
+
+#pragma once
+
+#include <chrono>
+#include <limits>
+
+namespace npipe {
+
+/**
+ * An absolute point in time until which an operation may take. As opposed to decrementing a timeout after every
+ * wait, this does not accumulate any drift.
+ */
+class Deadline {
+public:
+	using clock = std::chrono::steady_clock;
+
+	explicit Deadline(std::chrono::milliseconds timeout) : m_end(clock::time_point::max()) {
+		const clock::time_point now = clock::now();
+
+		if (timeout < std::chrono::duration_cast< std::chrono::milliseconds >(clock::time_point::max() - now)) {
+			m_end = now + timeout;
+		}
+	}
+
+	/**
+	 * @returns Whether the deadline has passed already
+	 */
+	[[nodiscard]] bool expired() const { return clock::now() >= m_end; }
+
+	/**
+	 * @returns The time left until the deadline is reached (rounded up to full milliseconds)
+	 */
+	[[nodiscard]] std::chrono::milliseconds remaining() const {
+		const clock::time_point now = clock::now();
+
+		if (now >= m_end) {
+			return std::chrono::milliseconds(0);
+		}
+
+		return std::chrono::ceil< std::chrono::milliseconds >(m_end - now);
+	}
+
+	/**
+	 * @returns The time left until the deadline is reached in a form suitable as a timeout for poll(). A
+	 * deadline that is too far in the future to be represented is turned into an infinite timeout (-1).
+	 */
+	[[nodiscard]] int pollTimeout() const {
+		if (m_end == clock::time_point::max()) {
+			return -1;
+		}
+
+		const std::chrono::milliseconds left = remaining();
+
+		if (left.count() > (std::numeric_limits< int >::max)()) {
+			return -1;
+		}
+
+		return static_cast< int >(left.count());
+	}
+
+	[[nodiscard]] clock::time_point get() const noexcept { return m_end; }
+
+private:
+	clock::time_point m_end;
+};
+
+} // namespace npipe
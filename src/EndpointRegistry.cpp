@@ -0,0 +1,337 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// source tree or at
+// <https://github.com/Krzmbrzl/NamedPipe/blob/main/LICENSE>.
+
+#include "npipe/EndpointRegistry.hpp"
+#include "npipe/EndpointUnavailableException.hpp"
+#include "npipe/PipeException.hpp"
+#include "npipe/TimeoutException.hpp"
+
+#ifdef __linux__
+#	include <array>
+#	include <cerrno>
+#	include <poll.h>
+#	include <sys/eventfd.h>
+#	include <sys/inotify.h>
+#	include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace npipe {
+
+struct EndpointRegistry::Endpoint {
+	using clock = std::chrono::steady_clock;
+
+	explicit Endpoint(const std::filesystem::path &pipePath)
+		: writer(pipePath), fileName(pipePath.filename().string()) {}
+
+	/**
+	 * Serializes access to the writer
+	 */
+	std::mutex mutex;
+	PipeWriter writer;
+	std::atomic_bool available = true;
+	/**
+	 * The point in time from which on writes are attempted again, even if the endpoint hasn't been found to be
+	 * available in the meantime
+	 */
+	std::atomic< clock::time_point > retryAfter = clock::time_point::min();
+	/**
+	 * The point in time at which the endpoint has last been written to
+	 */
+	std::atomic< clock::time_point > lastAccess = clock::now();
+	/**
+	 * The name of the pipe within its directory
+	 */
+	const std::string fileName;
+	/**
+	 * The inotify watch descriptor of the pipe's directory (-1 if not watched)
+	 */
+	std::atomic_int watchDescriptor = -1;
+};
+
+EndpointRegistry::EndpointRegistry(EndpointRegistryOptions options) : m_options(options) {
+#ifdef __linux__
+	m_watchHandle = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	m_stopHandle  = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+	if (m_stopHandle == -1) {
+		const int error = errno;
+
+		if (m_watchHandle != -1) {
+			::close(m_watchHandle);
+		}
+
+		throw PipeException< int >(error, "Create wakeup event");
+	}
+#endif
+
+	m_prober = std::thread([this]() { runProber(); });
+}
+
+EndpointRegistry::~EndpointRegistry() {
+	{
+		std::lock_guard< std::mutex > guard(m_mutex);
+		m_stop.store(true);
+	}
+
+	m_stopped.notify_all();
+
+#ifdef __linux__
+	const std::uint64_t increment = 1;
+	[[maybe_unused]] const ssize_t result = ::write(m_stopHandle, &increment, sizeof(increment));
+#endif
+
+	m_prober.join();
+
+#ifdef __linux__
+	for (int handle : { m_watchHandle, m_stopHandle }) {
+		if (handle != -1) {
+			::close(handle);
+		}
+	}
+#endif
+}
+
+void EndpointRegistry::write(const std::filesystem::path &pipePath, const std::byte *message,
+							 std::size_t messageSize, std::chrono::milliseconds timeout) {
+	assert(message);
+
+	access(pipePath, [&](PipeWriter &writer) { writer.write(message, messageSize, timeout); });
+}
+
+void EndpointRegistry::write_message(const std::filesystem::path &pipePath, const std::byte *message,
+									 std::size_t messageSize, std::chrono::milliseconds timeout) {
+	assert(message);
+
+	access(pipePath, [&](PipeWriter &writer) { writer.write_message(message, messageSize, timeout); });
+}
+
+bool EndpointRegistry::isAvailable(const std::filesystem::path &pipePath) const {
+	std::lock_guard< std::mutex > guard(m_mutex);
+
+	auto it = m_endpoints.find(pipePath);
+
+	// Endpoints we haven't written to yet are assumed to be available
+	return it == m_endpoints.end() || it->second->available.load();
+}
+
+std::size_t EndpointRegistry::size() const {
+	std::lock_guard< std::mutex > guard(m_mutex);
+
+	return m_endpoints.size();
+}
+
+std::shared_ptr< EndpointRegistry::Endpoint > EndpointRegistry::lookup(const std::filesystem::path &pipePath) {
+	std::lock_guard< std::mutex > guard(m_mutex);
+
+	std::shared_ptr< Endpoint > &endpoint = m_endpoints[pipePath];
+	if (!endpoint) {
+		endpoint = std::make_shared< Endpoint >(pipePath);
+	}
+
+	endpoint->lastAccess.store(Endpoint::clock::now());
+
+	return endpoint;
+}
+
+template< typename operation_t >
+void EndpointRegistry::access(const std::filesystem::path &pipePath, operation_t &&operation) {
+	const std::shared_ptr< Endpoint > sharedEndpoint = lookup(pipePath);
+	Endpoint &endpoint                               = *sharedEndpoint;
+
+	if (!endpoint.available.load() && Endpoint::clock::now() < endpoint.retryAfter.load()) {
+		throw EndpointUnavailableException();
+	}
+
+	std::lock_guard< std::mutex > guard(endpoint.mutex);
+
+	try {
+		operation(endpoint.writer);
+	} catch (const TimeoutException &) {
+		// Running out of time while being connected merely means that the reader doesn't keep up
+		if (!endpoint.writer.isConnected()) {
+			watch(endpoint);
+
+			// A reader that has shown up before the watch was in place wouldn't get reported, so give it one last
+			// chance now that it is
+			if (!endpoint.writer.try_connect()) {
+				markUnavailable(endpoint);
+			}
+		}
+
+		throw;
+	}
+
+	endpoint.available.store(true);
+}
+
+void EndpointRegistry::watch(Endpoint &endpoint) {
+#ifdef __linux__
+	if (m_watchHandle != -1 && endpoint.watchDescriptor.load() == -1) {
+		// Watching the same directory multiple times only updates (and returns) the existing watch
+		const std::filesystem::path pipePath  = endpoint.writer.getPath();
+		const std::filesystem::path directory = pipePath.has_parent_path() ? pipePath.parent_path() : ".";
+
+		endpoint.watchDescriptor.store(::inotify_add_watch(m_watchHandle, directory.c_str(), IN_CREATE | IN_MOVED_TO));
+	}
+#else
+	(void) endpoint;
+#endif
+}
+
+void EndpointRegistry::markUnavailable(Endpoint &endpoint) {
+	endpoint.retryAfter.store(Endpoint::clock::now() + m_options.coolDown);
+	endpoint.available.store(false);
+}
+
+void EndpointRegistry::evictIdle() {
+	const Endpoint::clock::time_point now = Endpoint::clock::now();
+
+	for (auto it = m_endpoints.begin(); it != m_endpoints.end();) {
+		// Endpoints that are being written to right now are never idle
+		if (it->second.use_count() > 1 || now - it->second->lastAccess.load() < m_options.evictAfter) {
+			++it;
+			continue;
+		}
+
+#ifdef __linux__
+		const int watchDescriptor = it->second->watchDescriptor.load();
+#endif
+
+		it = m_endpoints.erase(it);
+
+#ifdef __linux__
+		// The directory's watch is shared by all endpoints within it
+		if (watchDescriptor != -1
+			&& std::none_of(m_endpoints.begin(), m_endpoints.end(),
+							[&](const std::pair< const std::filesystem::path, std::shared_ptr< Endpoint > > &entry) {
+								return entry.second->watchDescriptor.load() == watchDescriptor;
+							})) {
+			::inotify_rm_watch(m_watchHandle, watchDescriptor);
+		}
+#endif
+	}
+}
+
+void EndpointRegistry::runProber() {
+	std::vector< std::shared_ptr< Endpoint > > unavailable;
+	std::vector< std::pair< int, std::string > > changed;
+	std::vector< int > lost;
+
+	while (!m_stop.load()) {
+		const bool probeAll = waitForProbe(changed, lost);
+
+		unavailable.clear();
+		{
+			std::lock_guard< std::mutex > guard(m_mutex);
+
+			if (probeAll) {
+				evictIdle();
+			}
+
+			for (auto &current : m_endpoints) {
+				Endpoint &endpoint = *current.second;
+
+				const bool watchLost =
+					std::find(lost.begin(), lost.end(), endpoint.watchDescriptor.load()) != lost.end();
+				if (watchLost) {
+					// The directory might get replaced by a new one, which would have to be watched instead
+					endpoint.watchDescriptor.store(-1);
+				}
+
+				if (endpoint.available.load()) {
+					continue;
+				}
+
+				const bool hasChanged =
+					std::any_of(changed.begin(), changed.end(), [&](const std::pair< int, std::string > &entry) {
+						return entry.first == endpoint.watchDescriptor.load() && entry.second == endpoint.fileName;
+					});
+
+				if (probeAll || hasChanged || watchLost) {
+					unavailable.push_back(current.second);
+				}
+			}
+		}
+
+		for (const std::shared_ptr< Endpoint > &endpoint : unavailable) {
+			if (endpoint->watchDescriptor.load() == -1) {
+				watch(*endpoint);
+			}
+
+			// If a write is in progress, that write will find out about the endpoint's state by itself
+			std::unique_lock< std::mutex > lock(endpoint->mutex, std::try_to_lock);
+
+			if (lock && endpoint->writer.try_connect()) {
+				endpoint->available.store(true);
+			}
+		}
+	}
+}
+
+bool EndpointRegistry::waitForProbe(std::vector< std::pair< int, std::string > > &changed, std::vector< int > &lost) {
+	changed.clear();
+	lost.clear();
+
+#ifdef __linux__
+	using clock = std::chrono::steady_clock;
+
+	std::array< pollfd, 2 > pollData = { pollfd{ m_stopHandle, POLLIN, 0 }, pollfd{ m_watchHandle, POLLIN, 0 } };
+	const nfds_t handleCount         = m_watchHandle != -1 ? 2 : 1;
+
+	// Events in a busy directory must not postpone the regular probe indefinitely
+	const auto untilFullProbe =
+		std::chrono::ceil< std::chrono::milliseconds >(std::max(m_nextFullProbe - clock::now(), clock::duration(0)));
+
+	if (::poll(pollData.data(), handleCount, static_cast< int >(untilFullProbe.count())) <= 0
+		|| !(pollData[1].revents & POLLIN)) {
+		// Either it's time for the regular probe or we are being stopped
+		m_nextFullProbe = clock::now() + m_options.probeInterval;
+		return true;
+	}
+
+	bool probeAll = clock::now() >= m_nextFullProbe;
+
+	alignas(inotify_event) std::array< char, 4096 > buffer;
+	ssize_t length;
+	while ((length = ::read(m_watchHandle, buffer.data(), buffer.size())) > 0) {
+		for (std::size_t offset = 0; offset < static_cast< std::size_t >(length);) {
+			const inotify_event *event = reinterpret_cast< const inotify_event * >(buffer.data() + offset);
+
+			if (event->mask & IN_Q_OVERFLOW) {
+				// Lost events might have concerned any endpoint
+				probeAll = true;
+			} else if (event->mask & IN_IGNORED) {
+				// The watch has been removed, either by us or because its directory is gone
+				lost.push_back(event->wd);
+			} else if (event->len > 0) {
+				changed.emplace_back(event->wd, event->name);
+			}
+
+			offset += sizeof(inotify_event) + event->len;
+		}
+	}
+
+	if (probeAll) {
+		m_nextFullProbe = clock::now() + m_options.probeInterval;
+	}
+
+	return probeAll;
+#else
+	std::unique_lock< std::mutex > lock(m_mutex);
+	m_stopped.wait_for(lock, m_options.probeInterval, [this]() { return m_stop.load(); });
+
+	return true;
+#endif
+}
+
+} // namespace npipe
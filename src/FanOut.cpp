@@ -0,0 +1,324 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// source tree or at
+// <https://github.com/Krzmbrzl/NamedPipe/blob/main/LICENSE>.
+
+#include "npipe/FanOut.hpp"
+#include "npipe/PipeException.hpp"
+#include "npipe/TimeoutException.hpp"
+
+#include "Deadline.hpp"
+
+#ifdef PIPE_PLATFORM_UNIX
+#	include "PosixUtils.hpp"
+
+#	include <fcntl.h>
+#	include <poll.h>
+#	include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <cerrno>
+#include <iostream>
+#include <utility>
+
+namespace npipe {
+
+std::size_t FanOut::destinationCount() const noexcept {
+	return m_destinations.size();
+}
+
+bool FanOut::isDropped(std::size_t index) const noexcept {
+	return index < m_destinations.size() && m_destinations[index].dropped;
+}
+
+std::size_t FanOut::backlogSize(std::size_t index) const noexcept {
+	if (index >= m_destinations.size()) {
+		return 0;
+	}
+
+	return m_destinations[index].backlog.size() - m_destinations[index].backlogOffset;
+}
+
+
+#ifdef PIPE_PLATFORM_UNIX
+/**
+ * The maximum amount of bytes that are forwarded in one go (the default capacity of a pipe on Linux)
+ */
+constexpr std::size_t FAN_OUT_CHUNK_SIZE = 64 * 1024;
+
+FanOut::FanOut(const NamedPipe &source, std::vector< std::filesystem::path > destinations, FanOutOptions options)
+	: m_source(source), m_options(options), m_duplicated(destinations.size()) {
+	m_destinations.reserve(destinations.size());
+	for (std::filesystem::path &current : destinations) {
+		m_destinations.push_back({ std::move(current), {}, 0, false, -1 });
+	}
+
+	// If this fails, duplicated content is discarded by reading it instead
+	m_discardHandle = ::open("/dev/null", O_WRONLY | O_CLOEXEC);
+}
+
+FanOut::~FanOut() {
+	for (Destination &current : m_destinations) {
+		disconnect(current);
+	}
+
+	if (m_discardHandle != -1) {
+		::close(m_discardHandle);
+	}
+}
+
+void FanOut::connect(Destination &destination) noexcept {
+	if (destination.handle != -1 || destination.dropped) {
+		return;
+	}
+
+	// Fails with ENXIO as long as there is no reader, in which case we'll try again next time
+	destination.handle = ::open(destination.path.c_str(), O_WRONLY | O_NONBLOCK | O_CLOEXEC);
+}
+
+void FanOut::disconnect(Destination &destination) noexcept {
+	if (destination.handle != -1) {
+		if (::close(destination.handle) != 0) {
+			std::cerr << "Failed at closing fan-out destination" << std::endl;
+		}
+
+		destination.handle = -1;
+	}
+
+	// Whatever hasn't been written yet belonged to the reader that has gone away
+	destination.backlog.clear();
+	destination.backlogOffset = 0;
+}
+
+bool FanOut::flush(Destination &destination) noexcept {
+	while (destination.backlogOffset < destination.backlog.size()) {
+		const ssize_t written = ::write(destination.handle, destination.backlog.data() + destination.backlogOffset,
+										destination.backlog.size() - destination.backlogOffset);
+
+		if (written < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			if (errno == EAGAIN || errno == EWOULDBLOCK) {
+				break;
+			}
+			if (errno == EPIPE) {
+				noteBrokenPipe();
+			}
+
+			disconnect(destination);
+
+			return false;
+		}
+
+		destination.backlogOffset += static_cast< std::size_t >(written);
+	}
+
+	if (destination.backlogOffset == destination.backlog.size()) {
+		destination.backlog.clear();
+		destination.backlogOffset = 0;
+	} else if (destination.backlogOffset > destination.backlog.size() / 2) {
+		// Don't let the already written part grow indefinitely
+		destination.backlog.erase(destination.backlog.begin(),
+								  destination.backlog.begin()
+									  + static_cast< std::ptrdiff_t >(destination.backlogOffset));
+		destination.backlogOffset = 0;
+	}
+
+	return true;
+}
+
+void FanOut::waitForBacklogs(const Deadline &deadline, const StopToken &stopToken) {
+	for (std::size_t i = 0; i < m_destinations.size(); ++i) {
+		Destination &current = m_destinations[i];
+
+		if (current.handle == -1 || !flush(current) || backlogSize(i) < m_options.maxBacklog) {
+			continue;
+		}
+
+		// Give the destination a chance to catch up before dropping it
+		const Deadline dropDeadline(m_options.dropSlowConsumers ? m_options.slowConsumerTimeout
+																 : std::chrono::milliseconds::max());
+
+		do {
+			const Status status =
+				waitFor(current.handle, POLLOUT, Deadline((std::min)(dropDeadline.remaining(), deadline.remaining())),
+						{ m_source.m_interruptSource.get_token().native_handle(), stopToken.native_handle() });
+
+			if (status == Status::Timeout && dropDeadline.expired()) {
+				disconnect(current);
+				current.dropped = true;
+				break;
+			}
+
+			throwOnFailure(status, "Poll");
+		} while (flush(current) && backlogSize(i) >= m_options.maxBacklog);
+	}
+}
+
+std::size_t FanOut::discard(std::size_t size) {
+	std::size_t discarded = 0;
+
+	while (m_discardHandle != -1 && discarded < size) {
+#	ifdef __linux__
+		const ssize_t result =
+			::splice(m_source.m_readHandle, nullptr, m_discardHandle, nullptr, size - discarded, SPLICE_F_MOVE);
+#	else
+		const ssize_t result = -1;
+		errno                = EINVAL;
+#	endif
+
+		if (result > 0) {
+			discarded += static_cast< std::size_t >(result);
+		} else if (result < 0 && errno == EINTR) {
+			continue;
+		} else {
+			// Splicing into /dev/null isn't supported -> read the content instead
+			break;
+		}
+	}
+
+	if (discarded < size) {
+		m_scratch.resize(size - discarded);
+
+		const ssize_t result = ::read(m_source.m_readHandle, m_scratch.data(), m_scratch.size());
+		if (result < 0) {
+			throw PipeException< int >(errno, "Read");
+		}
+
+		discarded += static_cast< std::size_t >(result);
+	}
+
+	return discarded;
+}
+
+std::size_t FanOut::forward(std::chrono::milliseconds timeout, const StopToken &stopToken) {
+	const Deadline deadline(timeout);
+
+	// Make sure a vanished reader results in EPIPE rather than in our process being killed
+	SigPipeGuard sigPipeGuard;
+
+	for (Destination &current : m_destinations) {
+		connect(current);
+	}
+
+	// Deal with slow destinations before taking more content out of the source
+	waitForBacklogs(deadline, stopToken);
+
+	throwOnFailure(m_source.waitForInput(deadline, stopToken), "Poll");
+
+	const std::size_t available =
+		(std::min)(availableBytes(m_source.m_readHandle).value_or(FAN_OUT_CHUNK_SIZE), FAN_OUT_CHUNK_SIZE);
+
+	bool duplicatedToAll = true;
+	for (std::size_t i = 0; i < m_destinations.size(); ++i) {
+		Destination &current = m_destinations[i];
+
+		// Destinations without reader don't get anything
+		m_duplicated[i] = available;
+
+		if (current.handle == -1) {
+			continue;
+		}
+
+		m_duplicated[i] = 0;
+
+#	ifdef __linux__
+		// Content must not overtake the backlog
+		if (current.backlog.empty()) {
+			ssize_t result;
+			do {
+				result = ::tee(m_source.m_readHandle, current.handle, available, SPLICE_F_NONBLOCK);
+			} while (result < 0 && errno == EINTR);
+
+			// tee() always duplicates from the start of the source, so whatever didn't fit in one go has to go to
+			// the backlog
+			if (result > 0) {
+				m_duplicated[i] = static_cast< std::size_t >(result);
+			} else if (result < 0 && errno == EPIPE) {
+				noteBrokenPipe();
+				disconnect(current);
+				m_duplicated[i] = available;
+			}
+			// Otherwise the destination is full (EAGAIN) or doesn't support tee() -> everything goes to the backlog
+		}
+#	endif
+
+		duplicatedToAll = duplicatedToAll && m_duplicated[i] == available;
+	}
+
+	if (duplicatedToAll) {
+		// Every destination references the content already -> there is no need to ever copy it
+		return discard(available);
+	}
+
+	// Take the content out of the source (that's the only copy) and hand the rest to the destinations' backlogs
+	m_scratch.resize(available);
+	ssize_t readBytes;
+	do {
+		readBytes = ::read(m_source.m_readHandle, m_scratch.data(), m_scratch.size());
+	} while (readBytes < 0 && errno == EINTR);
+
+	if (readBytes < 0) {
+		throw PipeException< int >(errno, "Read");
+	}
+
+	const std::size_t consumed = static_cast< std::size_t >(readBytes);
+
+	for (std::size_t i = 0; i < m_destinations.size(); ++i) {
+		Destination &current = m_destinations[i];
+
+		if (current.handle == -1 || m_duplicated[i] >= consumed) {
+			continue;
+		}
+
+		current.backlog.insert(current.backlog.end(),
+							   m_scratch.begin() + static_cast< std::ptrdiff_t >(m_duplicated[i]),
+							   m_scratch.begin() + static_cast< std::ptrdiff_t >(consumed));
+
+		flush(current);
+	}
+
+	return consumed;
+}
+#endif // PIPE_PLATFORM_UNIX
+
+#ifdef PIPE_PLATFORM_WINDOWS
+FanOut::FanOut(const NamedPipe &source, std::vector< std::filesystem::path > destinations, FanOutOptions options)
+	: m_source(source), m_options(options) {
+	m_destinations.reserve(destinations.size());
+	for (std::filesystem::path &current : destinations) {
+		m_destinations.push_back({ std::move(current), {}, 0, false });
+	}
+}
+
+FanOut::~FanOut() {
+}
+
+std::size_t FanOut::forward(std::chrono::milliseconds timeout, const StopToken &stopToken) {
+	const Deadline deadline(timeout);
+
+	const std::vector< std::byte > content = m_source.read_blocking(timeout, stopToken);
+
+	for (Destination &current : m_destinations) {
+		if (current.dropped) {
+			continue;
+		}
+
+		try {
+			NamedPipe::write(current.path, content.data(), content.size(), deadline.remaining());
+		} catch (const TimeoutException &) {
+			if (!m_options.dropSlowConsumers) {
+				throw;
+			}
+
+			current.dropped = true;
+		}
+	}
+
+	return content.size();
+}
+#endif // PIPE_PLATFORM_WINDOWS
+
+} // namespace npipe
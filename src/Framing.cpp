@@ -0,0 +1,161 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// source tree or at
+// <https://github.com/Krzmbrzl/NamedPipe/blob/main/LICENSE>.
+
+#include "npipe/Framing.hpp"
+#include "npipe/FramingException.hpp"
+#include "npipe/MessageBatch.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+namespace npipe {
+
+void FrameHeader::encode(std::byte *buffer) const noexcept {
+	assert(buffer);
+
+	buffer[0] = magic;
+	buffer[1] = std::byte(flags);
+	buffer[2] = std::byte(0);
+	buffer[3] = std::byte(0);
+
+	for (std::size_t i = 0; i < 4; ++i) {
+		buffer[4 + i] = std::byte((length >> (8 * i)) & 0xFF);
+	}
+}
+
+FrameHeader FrameHeader::decode(const std::byte *buffer) {
+	assert(buffer);
+
+	if (buffer[0] != magic || buffer[1] != std::byte(0) || buffer[2] != std::byte(0) || buffer[3] != std::byte(0)) {
+		throw FramingException();
+	}
+
+	FrameHeader header;
+	for (std::size_t i = 0; i < 4; ++i) {
+		header.length |= static_cast< std::uint32_t >(std::to_integer< std::uint8_t >(buffer[4 + i])) << (8 * i);
+	}
+
+	if (header.length > maxLength) {
+		throw FramingException();
+	}
+
+	return header;
+}
+
+
+void FrameDecoder::feed(const std::byte *data, std::size_t size) {
+	std::memcpy(prepare(size), data, size);
+	commit(size);
+}
+
+std::byte *FrameDecoder::prepare(std::size_t size) {
+	compact();
+
+	if (m_buffer.size() < m_size + size) {
+		m_buffer.resize(m_size + size);
+	}
+
+	return m_buffer.data() + m_size;
+}
+
+void FrameDecoder::commit(std::size_t size) noexcept {
+	assert(m_size + size <= m_buffer.size());
+
+	m_size += size;
+}
+
+bool FrameDecoder::next(std::vector< std::byte > &message) {
+	std::size_t length;
+	const std::byte *payload = extract(length);
+
+	if (!payload) {
+		return false;
+	}
+
+	message.assign(payload, payload + length);
+
+	return true;
+}
+
+bool FrameDecoder::next(MessageBatch &batch) {
+	std::size_t length;
+	const std::byte *payload = extract(length);
+
+	if (!payload) {
+		return false;
+	}
+
+	batch.append(payload, length);
+
+	return true;
+}
+
+const std::byte *FrameDecoder::extract(std::size_t &length) {
+	if (bufferedSize() < FrameHeader::size) {
+		return nullptr;
+	}
+
+	FrameHeader header;
+	try {
+		header = FrameHeader::decode(m_buffer.data() + m_offset);
+	} catch (const FramingException &) {
+		// Otherwise every following read would trip over the same bytes again
+		resynchronize();
+
+		throw;
+	}
+
+	if (bufferedSize() < FrameHeader::size + header.length) {
+		// The frame hasn't been received completely yet
+		return nullptr;
+	}
+
+	const std::byte *payload = m_buffer.data() + m_offset + FrameHeader::size;
+	length                   = header.length;
+
+	m_offset += FrameHeader::size + header.length;
+
+	if (m_offset == m_size) {
+		// Everything has been consumed -> start from the beginning of the buffer again. The payload stays intact
+		// until the buffer is written to the next time.
+		m_offset = 0;
+		m_size   = 0;
+	}
+
+	return payload;
+}
+
+std::size_t FrameDecoder::bufferedSize() const noexcept {
+	return m_size - m_offset;
+}
+
+void FrameDecoder::reset() noexcept {
+	m_offset = 0;
+	m_size   = 0;
+}
+
+void FrameDecoder::resynchronize() noexcept {
+	const auto begin = m_buffer.begin() + static_cast< std::ptrdiff_t >(m_offset + 1);
+	const auto end   = m_buffer.begin() + static_cast< std::ptrdiff_t >(m_size);
+
+	m_offset = static_cast< std::size_t >(std::find(begin, end, FrameHeader::magic) - m_buffer.begin());
+
+	if (m_offset == m_size) {
+		reset();
+	}
+}
+
+void FrameDecoder::compact() {
+	if (m_offset > 0 && m_offset >= bufferedSize()) {
+		std::copy(m_buffer.begin() + static_cast< std::ptrdiff_t >(m_offset),
+				  m_buffer.begin() + static_cast< std::ptrdiff_t >(m_size), m_buffer.begin());
+
+		m_size -= m_offset;
+		m_offset = 0;
+	}
+}
+
+} // namespace npipe
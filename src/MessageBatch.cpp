@@ -0,0 +1,24 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// source tree or at
+// <https://github.com/Krzmbrzl/NamedPipe/blob/main/LICENSE>.
+
+#include "npipe/MessageBatch.hpp"
+
+#include <cassert>
+
+namespace npipe {
+
+void MessageBatch::append(const std::byte *payload, std::size_t size) {
+	assert(payload || size == 0);
+
+	m_offsets.push_back(m_arena.size());
+	m_arena.insert(m_arena.end(), payload, payload + size);
+}
+
+void MessageBatch::clear() noexcept {
+	m_arena.clear();
+	m_offsets.clear();
+}
+
+} // namespace npipe
@@ -0,0 +1,162 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// source tree or at
+// <https://github.com/Krzmbrzl/NamedPipe/blob/main/LICENSE>.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+namespace npipe {
+
+/**
+ * Bounded lock-free queue with any amount of producers and a single consumer (see Dmitry Vyukov's bounded MPMC
+ * queue, of which we only use the MPSC part). The slots are reused, so values that own memory (e.g. vectors) only
+ * allocate until they have grown to their typical size.
+ */
+template< typename value_t > class MpscRing {
+public:
+	struct Slot {
+		value_t value;
+		/**
+		 * Set if the value couldn't be filled in, in which case the consumer has to skip the slot
+		 */
+		bool discarded = false;
+	};
+
+	/**
+	 * @param capacity The maximum amount of values the queue can hold (rounded up to the next power of two)
+	 */
+	explicit MpscRing(std::size_t capacity) {
+		std::size_t size = 2;
+		while (size < capacity) {
+			size <<= 1;
+		}
+
+		m_cells = std::make_unique< Cell[] >(size);
+		m_mask  = size - 1;
+
+		for (std::size_t i = 0; i < size; ++i) {
+			m_cells[i].sequence.store(i, std::memory_order_relaxed);
+		}
+	}
+
+	MpscRing(const MpscRing &) = delete;
+	MpscRing &operator=(const MpscRing &) = delete;
+
+	/**
+	 * Claims a slot, fills it in via the given function and publishes it to the consumer. This function is
+	 * thread-safe.
+	 *
+	 * @param fill Function receiving the value (of a previous use of the slot) to overwrite
+	 * @returns Whether there was a free slot
+	 *
+	 * @throws Whatever the fill function throws. The slot is published as discarded in that case.
+	 */
+	template< typename fill_t > bool try_push(fill_t &&fill) {
+		std::size_t pos = m_writePos.load(std::memory_order_relaxed);
+		Cell *cell;
+		while (true) {
+			cell = &m_cells[pos & m_mask];
+
+			const std::size_t sequence = cell->sequence.load(std::memory_order_acquire);
+			const std::ptrdiff_t diff  = static_cast< std::ptrdiff_t >(sequence - pos);
+
+			if (diff == 0) {
+				if (m_writePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+					break;
+				}
+			} else if (diff < 0) {
+				// The queue is full
+				return false;
+			} else {
+				// Another producer has claimed this slot in the meantime
+				pos = m_writePos.load(std::memory_order_relaxed);
+			}
+		}
+
+		try {
+			fill(cell->slot.value);
+			cell->slot.discarded = false;
+		} catch (...) {
+			// The slot has been claimed already, so it has to be published in any case
+			cell->slot.discarded = true;
+			cell->sequence.store(pos + 1);
+
+			throw;
+		}
+
+		cell->sequence.store(pos + 1);
+
+		return true;
+	}
+
+	/**
+	 * Must only be called by the consumer.
+	 *
+	 * @param offset The offset from the read position
+	 * @returns The slot at the given offset if it has been published, nullptr otherwise
+	 */
+	[[nodiscard]] Slot *peek(std::size_t offset = 0) noexcept {
+		const std::size_t pos = m_readPos.load(std::memory_order_relaxed) + offset;
+		Cell &cell            = m_cells[pos & m_mask];
+
+		if (offset > m_mask || cell.sequence.load() != pos + 1) {
+			return nullptr;
+		}
+
+		return &cell.slot;
+	}
+
+	[[nodiscard]] const Slot *peek(std::size_t offset = 0) const noexcept {
+		return const_cast< MpscRing * >(this)->peek(offset);
+	}
+
+	/**
+	 * Hands the given amount of slots (starting at the read position) back to the producers. Must only be called by
+	 * the consumer and only for published slots.
+	 */
+	void pop(std::size_t count = 1) noexcept {
+		const std::size_t readPos = m_readPos.load(std::memory_order_relaxed);
+
+		for (std::size_t i = 0; i < count; ++i) {
+			m_cells[(readPos + i) & m_mask].sequence.store(readPos + i + m_mask + 1, std::memory_order_release);
+		}
+
+		m_readPos.store(readPos + count);
+	}
+
+	/**
+	 * @returns The maximum amount of values the queue can hold
+	 */
+	[[nodiscard]] std::size_t capacity() const noexcept { return m_mask + 1; }
+
+	/**
+	 * @returns The position at which the next value will be enqueued
+	 */
+	[[nodiscard]] std::size_t writePosition() const noexcept { return m_writePos.load(); }
+
+	/**
+	 * @returns The position of the oldest value that hasn't been popped yet
+	 */
+	[[nodiscard]] std::size_t readPosition() const noexcept { return m_readPos.load(); }
+
+private:
+	struct Cell {
+		/**
+		 * Equals the cell's position if the cell is free, its position + 1 if it holds a published value and the
+		 * position + capacity once the value has been popped
+		 */
+		std::atomic_size_t sequence;
+		Slot slot;
+	};
+
+	std::unique_ptr< Cell[] > m_cells;
+	std::size_t m_mask;
+	alignas(64) std::atomic_size_t m_writePos = 0;
+	alignas(64) std::atomic_size_t m_readPos  = 0;
+};
+
+} // namespace npipe
@@ -4,26 +4,42 @@
 // <https://github.com/Krzmbrzl/NamedPipe/blob/main/LICENSE>.
 
 #include "npipe/NamedPipe.hpp"
+#include "npipe/AsyncWriter.hpp"
+#include "npipe/FramingException.hpp"
 #include "npipe/InterruptException.hpp"
 #include "npipe/PipeException.hpp"
+#include "npipe/PipeWriter.hpp"
 #include "npipe/TimeoutException.hpp"
 
+#include "Deadline.hpp"
+
 #ifdef PIPE_PLATFORM_UNIX
+#	include "CapacityController.hpp"
+#	include "PosixUtils.hpp"
+
 #	include <fcntl.h>
 #	include <unistd.h>
 #	include <poll.h>
 #	include <sys/stat.h>
+#	include <sys/uio.h>
 #endif
 
 #ifdef PIPE_PLATFORM_WINDOWS
 #	include <windows.h>
 #endif
 
+#include <algorithm>
 #include <array>
 #include <cassert>
 #include <chrono>
+#include <cstdint>
 #include <fstream>
+#include <initializer_list>
 #include <iostream>
+#include <limits>
+#include <new>
+#include <optional>
+#include <string>
 #include <thread>
 
 
@@ -102,115 +118,592 @@ void NamedPipe::write(const std::byte *message, std::size_t messageSize, std::ch
 	write(m_pipePath, message, messageSize, timeout);
 }
 
+MessageBatch NamedPipe::read_batch(std::chrono::milliseconds timeout, const StopToken &stopToken) const {
+	MessageBatch batch;
+	read_batch(batch, timeout, stopToken);
+
+	return batch;
+}
+
+std::size_t NamedPipe::write_file(std::filesystem::path pipePath, const std::filesystem::path &filePath,
+								 std::uint64_t offset, std::size_t length, std::chrono::milliseconds timeout) {
+	return PipeWriter(std::move(pipePath)).write_file(filePath, offset, length, timeout);
+}
+
+void NamedPipe::write_message(const std::byte *message, std::size_t messageSize,
+							  std::chrono::milliseconds timeout) const {
+	assert(message);
+	write_message(m_pipePath, message, messageSize, timeout);
+}
+
+/**
+ * @returns The writer serving NamedPipe::write_async. It is created on first use and finishes its queued writes when
+ * the program exits.
+ */
+static AsyncWriter &sharedAsyncWriter() {
+	static AsyncWriter writer;
+
+	return writer;
+}
+
+bool NamedPipe::write_async(const std::filesystem::path &pipePath, const std::byte *message, std::size_t messageSize,
+							std::function< void(Result< std::size_t > result) > completion,
+							std::chrono::milliseconds timeout) {
+	return sharedAsyncWriter().write_async(pipePath, message, messageSize, std::move(completion), timeout);
+}
+
+std::future< Result< std::size_t > > NamedPipe::write_async(const std::filesystem::path &pipePath,
+															const std::byte *message, std::size_t messageSize,
+															std::chrono::milliseconds timeout) {
+	return sharedAsyncWriter().write_async(pipePath, message, messageSize, timeout);
+}
+
 NamedPipe::operator bool() const noexcept {
 	return !m_pipePath.empty();
 }
 
 void NamedPipe::interrupt() {
 	m_break.store(true);
+
+#ifdef PIPE_PLATFORM_UNIX
+	m_interruptSource.request_stop();
+#endif
 }
 
 
 #ifdef PIPE_PLATFORM_UNIX
 using handle_t = FileHandleWrapper< int, int (*)(int), -1, 0 >;
 
-NamedPipe NamedPipe::create(std::filesystem::path pipePath) {
+constexpr std::size_t PIPE_READ_CHUNK_SIZE = 64 * 1024;
+
+/**
+ * Adapter for reading into a container that is resized as needed
+ */
+template< typename container_t > struct ContainerSink {
+	container_t &container;
+	std::size_t offset = 0;
+
+	std::byte *prepare(std::size_t size) {
+		offset = container.size();
+		container.resize(offset + size);
+
+		return container.data() + offset;
+	}
+
+	void commit(std::size_t size) { container.resize(offset + size); }
+};
+
+/**
+ * Reads all content that is currently available from the given pipe handle into the given sink. If possible, the
+ * amount of available content is queried up front, so that everything can be read with a single read() call.
+ *
+ * @param handle The (non-blocking) pipe handle to read from
+ * @param sink Object providing prepare(size) and commit(size) functions for obtaining memory to read into
+ */
+template< typename sink_t > static void readAvailableInto(int handle, sink_t &sink) {
+	while (true) {
+		const std::optional< std::size_t > available = availableBytes(handle);
+		if (available && *available == 0) {
+			return;
+		}
+
+		const std::size_t chunkSize = available.value_or(PIPE_READ_CHUNK_SIZE);
+
+		const ssize_t readBytes = ::read(handle, sink.prepare(chunkSize), chunkSize);
+
+		if (readBytes < 0) {
+			sink.commit(0);
+
+			// EAGAIN means that we have read everything there is
+			if (errno == EAGAIN) {
+				return;
+			}
+			if (errno == EINTR) {
+				continue;
+			}
+
+			throw PipeException< int >(errno, "Read");
+		}
+
+		sink.commit(static_cast< std::size_t >(readBytes));
+
+		if (available || readBytes == 0) {
+			// We have read exactly what has been available at the time
+			return;
+		}
+	}
+}
+
+static void readAvailable(int handle, std::vector< std::byte > &content) {
+	ContainerSink< std::vector< std::byte > > sink{ content };
+	readAvailableInto(handle, sink);
+}
+
+static void readAvailable(int handle, FrameDecoder &decoder) {
+	readAvailableInto(handle, decoder);
+}
+
+/**
+ * Moves all content that is currently available from the given pipe handle to the given destination by copying it
+ * through user space
+ *
+ * @param source The (non-blocking) pipe handle to read from
+ * @param destination The file descriptor to write to
+ * @param chunkSize The size of the intermediate buffer
+ * @returns The amount of bytes that have been moved
+ */
+static std::size_t copyAvailable(int source, int destination, std::size_t chunkSize) {
+	std::vector< std::byte > buffer(chunkSize);
+	std::size_t moved = 0;
+
+	while (true) {
+		const ssize_t readBytes = ::read(source, buffer.data(), buffer.size());
+
+		if (readBytes < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			if (errno == EAGAIN) {
+				return moved;
+			}
+
+			throw PipeException< int >(errno, "Read");
+		}
+
+		if (readBytes == 0) {
+			return moved;
+		}
+
+		// Once taken out of the pipe, the content has nowhere else to go -> don't give up on it
+		iovec pending       = { buffer.data(), static_cast< std::size_t >(readBytes) };
+		std::size_t written = 0;
+		throwOnFailure(writeAll(destination, &pending, 1, Deadline(std::chrono::milliseconds::max()), written),
+					   "Write");
+
+		moved += written;
+	}
+}
+
+NamedPipe NamedPipe::create(std::filesystem::path pipePath, std::size_t capacity) {
+	// The fifo is set up under a temporary name and only published at its final location once it is ready to be
+	// written to. That way, writers waiting for the pipe to show up can connect right away.
+	static std::atomic_uint32_t pipeCounter = 0;
+
+	std::filesystem::path setupPath = pipePath;
+	setupPath.replace_filename("." + pipePath.filename().string() + "." + std::to_string(::getpid()) + "."
+							   + std::to_string(pipeCounter++));
+
 	// Create fifo that only the same user can read & write
-	if (mkfifo(pipePath.c_str(), S_IRUSR | S_IWUSR) != 0) {
+	if (mkfifo(setupPath.c_str(), S_IRUSR | S_IWUSR) != 0) {
+		throw PipeException< int >(errno, "Create");
+	}
+
+	// Should anything go wrong from here on, the wrapper takes care of removing the fifo again
+	NamedPipe pipe(setupPath);
+
+	// Keep the pipe open for reading for as long as the wrapper exists. This also makes sure that writers can
+	// always connect to the pipe without having to wait for a reader to show up.
+	pipe.m_readHandle = ::open(setupPath.c_str(), O_RDONLY | O_NONBLOCK);
+	if (pipe.m_readHandle == -1) {
+		throw PipeException< int >(errno, "Open");
+	}
+
+	// Since there is a reader now, opening the writing end in non-blocking mode can't fail with ENXIO
+	pipe.m_guardHandle = ::open(setupPath.c_str(), O_WRONLY | O_NONBLOCK);
+	if (pipe.m_guardHandle == -1) {
+		throw PipeException< int >(errno, "Open");
+	}
+
+	if (capacity > 0) {
+		pipe.setCapacity(capacity);
+	}
+
+	// Publish the pipe. As opposed to rename(), link() refuses to replace an existing file.
+	if (::link(setupPath.c_str(), pipePath.c_str()) != 0) {
 		throw PipeException< int >(errno, "Create");
 	}
 
-	return NamedPipe(pipePath);
+	::unlink(setupPath.c_str());
+	pipe.m_pipePath = std::move(pipePath);
+
+	return pipe;
 }
 
 void NamedPipe::write(std::filesystem::path pipePath, const std::byte *message, std::size_t messageSize,
 					  std::chrono::milliseconds timeout) {
 	assert(message);
 
-	// Wait until the target pipe is found or until the provided timeout has elapsed
-	handle_t handle;
-	do {
-		handle = handle_t(::open(pipePath.c_str(), O_WRONLY | O_NONBLOCK), &::close);
+	PipeWriter(std::move(pipePath)).write(message, messageSize, timeout);
+}
 
-		if (!handle) {
-			if (timeout > PIPE_WRITE_WAIT_INTERVAL) {
-				timeout -= PIPE_WRITE_WAIT_INTERVAL;
-				std::this_thread::sleep_for(PIPE_WRITE_WAIT_INTERVAL);
-			} else {
-				throw TimeoutException();
-			}
-		}
-	} while (!handle);
+std::size_t NamedPipe::write_partial(std::filesystem::path pipePath, const std::byte *message,
+									 std::size_t messageSize, std::chrono::milliseconds timeout) {
+	assert(message);
 
-	// Once the pipe exists, write the desired content to it
-	if (::write(handle, message, messageSize) < 0) {
-		throw PipeException< int >(errno, "Write");
+	return PipeWriter(std::move(pipePath)).write_partial(message, messageSize, timeout);
+}
+
+Result< std::size_t > NamedPipe::try_write(const std::filesystem::path &pipePath, const std::byte *message,
+										   std::size_t messageSize, std::chrono::milliseconds timeout) noexcept {
+	assert(message);
+
+	try {
+		// The writer needs a copy of the path
+		return PipeWriter(pipePath).try_write(message, messageSize, timeout);
+	} catch (const std::bad_alloc &) {
+		return Result< std::size_t >(Status::Error, 0, ENOMEM);
 	}
 }
 
+void NamedPipe::write_gather(std::filesystem::path pipePath, const ConstBuffer *buffers, std::size_t bufferCount,
+							 std::chrono::milliseconds timeout) {
+	assert(buffers || bufferCount == 0);
+
+	PipeWriter(std::move(pipePath)).write_gather(buffers, bufferCount, timeout);
+}
+
+void NamedPipe::write_zero_copy(std::filesystem::path pipePath, PageAlignedBuffer buffer,
+								std::chrono::milliseconds timeout) {
+	PipeWriter(std::move(pipePath)).write_zero_copy(std::move(buffer), timeout);
+}
+
+void NamedPipe::write_message(std::filesystem::path pipePath, const std::byte *message, std::size_t messageSize,
+							  std::chrono::milliseconds timeout) {
+	assert(message);
+
+	PipeWriter(std::move(pipePath)).write_message(message, messageSize, timeout);
+}
+
+std::size_t NamedPipe::write_many(std::filesystem::path pipePath, const ConstBuffer *messages,
+								 std::size_t messageCount, std::chrono::milliseconds timeout) {
+	assert(messages || messageCount == 0);
+
+	return PipeWriter(std::move(pipePath)).write_many(messages, messageCount, timeout);
+}
+
 bool NamedPipe::exists(const std::filesystem::path &pipePath) {
 	// We don't explicitly check whether the given path is a pipe or a regular file
 	return std::filesystem::exists(pipePath);
 }
 
-std::vector< std::byte > NamedPipe::read_blocking(std::chrono::milliseconds timeout) const {
+Status NamedPipe::waitForInput(const Deadline &deadline, const StopToken &stopToken) const noexcept {
+	if (m_readHandle == -1) {
+		errno = EBADF;
+		return Status::Closed;
+	}
+
+	if (m_break || stopToken.stop_requested()) {
+		return Status::Interrupted;
+	}
+
+	const std::initializer_list< int > interruptHandles = { m_interruptSource.get_token().native_handle(),
+															 stopToken.native_handle() };
+
+	if (!m_capacityController) {
+		// Sleep until there is something to read, the deadline has passed or we get interrupted
+		return waitFor(m_readHandle, POLLIN, deadline, interruptHandles);
+	}
+
+	while (true) {
+		// Wake up regularly, so that the pipe gets shrunk while it is idle even if the reader keeps waiting
+		const Deadline step((std::min)(deadline.remaining(), m_capacityController->idleCheckInterval()));
+
+		const Status status = waitFor(m_readHandle, POLLIN, step, interruptHandles);
+
+		if (status == Status::Ok) {
+			// Right before reading, the fill level tells how close the pipe has come to running full
+			m_capacityController->sample(availableBytes(m_readHandle).value_or(0));
+		} else if (status == Status::Timeout) {
+			m_capacityController->checkIdle(availableBytes(m_readHandle).value_or(0));
+
+			if (!deadline.expired()) {
+				continue;
+			}
+		}
+
+		return status;
+	}
+}
+
+std::size_t NamedPipe::setCapacity(std::size_t capacity) {
+	const std::optional< std::size_t > resulting = resizePipe(m_readHandle, capacity);
+
+	if (!resulting) {
+		throw PipeException< int >(errno, "Resize");
+	}
+
+	return *resulting;
+}
+
+std::size_t NamedPipe::getCapacity() const {
+	return pipeCapacity(m_readHandle).value_or(0);
+}
+
+void NamedPipe::enableAdaptiveCapacity(const AdaptiveCapacityOptions &options) {
+	m_capacityController = std::make_unique< CapacityController >(m_readHandle, options);
+}
+
+void NamedPipe::disableAdaptiveCapacity() {
+	m_capacityController.reset();
+}
+
+CapacityMetrics NamedPipe::getCapacityMetrics() const {
+	CapacityMetrics metrics;
+	metrics.fillLevel = availableBytes(m_readHandle).value_or(0);
+
+	if (m_capacityController) {
+		// Pipes that aren't read from at all have no other chance of being shrunk
+		m_capacityController->checkIdle(metrics.fillLevel);
+		m_capacityController->collect(metrics);
+	}
+
+	metrics.capacity = getCapacity();
+
+	return metrics;
+}
+
+std::vector< std::byte > NamedPipe::read_blocking(std::chrono::milliseconds timeout,
+												  const StopToken &stopToken) const {
 	std::vector< std::byte > message;
 
-	// At this point, we are assuming that the pipe already exists
-	handle_t handle(::open(m_pipePath.c_str(), O_RDONLY | O_NONBLOCK), &::close);
+	throwOnFailure(waitForInput(Deadline(timeout), stopToken), "Poll");
 
-	if (handle == -1) {
-		throw PipeException< int >(errno, "Open");
+	readAvailable(m_readHandle, message);
+
+	return message;
+}
+
+#	ifdef __cpp_lib_memory_resource
+std::pmr::vector< std::byte > NamedPipe::read_blocking(std::pmr::memory_resource *resource,
+													   std::chrono::milliseconds timeout,
+													   const StopToken &stopToken) const {
+	std::pmr::vector< std::byte > message(resource);
+
+	throwOnFailure(waitForInput(Deadline(timeout), stopToken), "Poll");
+
+	// The content is read straight into the returned vector, so there is no accumulation buffer that could
+	// allocate from anywhere else
+	ContainerSink< std::pmr::vector< std::byte > > sink{ message };
+	readAvailableInto(m_readHandle, sink);
+
+	return message;
+}
+#	endif
+
+Message NamedPipe::read_blocking(BufferPool &pool, std::chrono::milliseconds timeout,
+								 const StopToken &stopToken) const {
+	throwOnFailure(waitForInput(Deadline(timeout), stopToken), "Poll");
+
+	// Pick a buffer that is big enough to hold everything that is available right away
+	Message message = pool.acquire(availableBytes(m_readHandle).value_or(0));
+	message.resize(0);
+
+	ContainerSink< Message > sink{ message };
+	readAvailableInto(m_readHandle, sink);
+
+	return message;
+}
+
+std::size_t NamedPipe::read_into(std::byte *buffer, std::size_t bufferSize, std::chrono::milliseconds timeout,
+								 const StopToken &stopToken) const {
+	assert(buffer);
+
+	return unwrap(try_read(buffer, bufferSize, timeout, stopToken), "Read");
+}
+
+Result< std::size_t > NamedPipe::try_read(std::byte *buffer, std::size_t bufferSize, std::chrono::milliseconds timeout,
+										  const StopToken &stopToken) const noexcept {
+	assert(buffer);
+
+	const Deadline deadline(timeout);
+
+	while (true) {
+		const Status status = waitForInput(deadline, stopToken);
+
+		if (status != Status::Ok) {
+			return Result< std::size_t >(status, 0, status == Status::Error || status == Status::Closed ? errno : 0);
+		}
+
+		// A single read hands us everything that is available (up to the buffer's size)
+		const ssize_t readBytes = ::read(m_readHandle, buffer, bufferSize);
+
+		if (readBytes >= 0) {
+			return Result< std::size_t >(Status::Ok, static_cast< std::size_t >(readBytes));
+		}
+
+		if (errno != EAGAIN && errno != EINTR) {
+			return Result< std::size_t >(Status::Error, 0, errno);
+		}
+
+		// Someone else has been quicker at reading the available content -> wait for more
 	}
+}
 
-	pollfd pollData = { handle, POLLIN, -1 };
-	while (::poll(&pollData, 1, std::chrono::duration_cast< std::chrono::milliseconds >(PIPE_WAIT_INTERVAL).count())
-			   != -1
-		   && !(pollData.revents & POLLIN)) {
-		// Check if the thread has been interrupted
-		if (m_break) {
-			throw InterruptException();
+std::vector< std::byte > NamedPipe::read_message(std::chrono::milliseconds timeout,
+												 const StopToken &stopToken) const {
+	std::vector< std::byte > message;
+
+	const Deadline deadline(timeout);
+
+	while (!m_decoder.next(message)) {
+		throwOnFailure(waitForInput(deadline, stopToken), "Poll");
+
+		// Read everything that is available straight into the decoder
+		readAvailable(m_readHandle, m_decoder);
+	}
+
+	return message;
+}
+
+std::size_t NamedPipe::read_batch(MessageBatch &batch, std::chrono::milliseconds timeout,
+								 const StopToken &stopToken) const {
+	batch.clear();
+
+	const Deadline deadline(timeout);
+
+	while (true) {
+		while (m_decoder.next(batch)) {
 		}
 
-		if (timeout > PIPE_WAIT_INTERVAL) {
-			timeout -= PIPE_WAIT_INTERVAL;
-		} else {
-			throw TimeoutException();
+		if (!batch.empty()) {
+			return batch.size();
 		}
+
+		throwOnFailure(waitForInput(deadline, stopToken), "Poll");
+
+		// A single read usually hands us plenty of messages at once
+		readAvailable(m_readHandle, m_decoder);
 	}
+}
 
-	std::array< std::byte, PIPE_BUFFER_SIZE > buffer;
+std::size_t NamedPipe::read_available(MessageBatch &batch) const {
+	batch.clear();
 
-	ssize_t readBytes;
-	while ((readBytes = ::read(handle, buffer.data(), PIPE_BUFFER_SIZE)) > 0) {
-		message.insert(message.end(), buffer.begin(), buffer.begin() + readBytes);
+	if (m_readHandle == -1) {
+		throw PipeException< int >(EBADF, "Read");
 	}
 
-	// 0 Means there is no more input, negative numbers indicate errors
-	// If the error simply is EAGAIN this means that the message has been read completely
-	// and a request for further data would block (since atm there is no more data available).
-	if (readBytes == -1 && errno != EAGAIN) {
-		throw PipeException< int >(errno, "Read");
+	if (m_capacityController) {
+		m_capacityController->sample(availableBytes(m_readHandle).value_or(0));
 	}
 
-	return message;
+	readAvailable(m_readHandle, m_decoder);
+
+	while (m_decoder.next(batch)) {
+	}
+
+	return batch.size();
+}
+
+int NamedPipe::native_handle() const noexcept {
+	return m_readHandle;
 }
 
-NamedPipe::NamedPipe(NamedPipe &&other) : m_pipePath(std::move(other.m_pipePath)) {
+ReadAwaitable NamedPipe::async_read(Reactor &reactor, std::chrono::milliseconds timeout, StopToken stopToken) const {
+	return ReadAwaitable(*this, reactor, timeout, std::move(stopToken));
+}
+
+std::size_t NamedPipe::relay_to(int fd, std::chrono::milliseconds timeout, const StopToken &stopToken,
+								std::size_t chunkSize) const {
+	assert(chunkSize > 0);
+
+	const Deadline deadline(timeout);
+
+	throwOnFailure(waitForInput(deadline, stopToken), "Poll");
+
+	// Make sure a vanished reader on the destination's end results in EPIPE rather than in our process being killed
+	SigPipeGuard sigPipeGuard;
+
+	std::size_t moved = 0;
+
+#	ifdef __linux__
+	while (true) {
+		// As our end is a pipe, the content can be moved to any descriptor directly - no intermediate pipe required
+		const ssize_t result =
+			::splice(m_readHandle, nullptr, fd, nullptr, chunkSize, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+
+		if (result > 0) {
+			moved += static_cast< std::size_t >(result);
+			continue;
+		}
+
+		if (result == 0) {
+			return moved;
+		}
+
+		if (errno == EINTR) {
+			continue;
+		}
+
+		if (errno == EINVAL || errno == ENOSYS) {
+			// The destination doesn't support splicing
+			break;
+		}
+
+		if (errno != EAGAIN) {
+			throw PipeException< int >(errno, "Splice");
+		}
+
+		if (availableBytes(m_readHandle).value_or(0) == 0) {
+			// We have relayed everything there is
+			return moved;
+		}
+
+		// The destination can't take any more data right now -> wait for it to have room again
+		const Status status = waitFor(fd, POLLOUT, deadline,
+									  { m_interruptSource.get_token().native_handle(), stopToken.native_handle() });
+
+		if (status != Status::Ok) {
+			if (moved > 0 && status != Status::Error) {
+				return moved;
+			}
+
+			throwOnFailure(status, "Poll");
+		}
+	}
+#	endif
+
+	return moved + copyAvailable(m_readHandle, fd, chunkSize);
+}
+
+NamedPipe::NamedPipe(NamedPipe &&other)
+	: m_pipePath(std::move(other.m_pipePath)), m_decoder(std::move(other.m_decoder)),
+	  m_readHandle(other.m_readHandle), m_guardHandle(other.m_guardHandle),
+	  m_interruptSource(std::move(other.m_interruptSource)),
+	  m_capacityController(std::move(other.m_capacityController)) {
 	other.m_pipePath.clear();
+	other.m_readHandle  = -1;
+	other.m_guardHandle = -1;
 }
 
 NamedPipe &NamedPipe::operator=(NamedPipe &&other) {
-	m_pipePath = std::move(other.m_pipePath);
+	if (this == &other) {
+		return *this;
+	}
+
+	destroy();
+
+	m_pipePath    = std::move(other.m_pipePath);
+	m_decoder     = std::move(other.m_decoder);
+	m_readHandle  = other.m_readHandle;
+	m_guardHandle = other.m_guardHandle;
+	m_break.store(other.m_break.load());
+	m_interruptSource    = std::move(other.m_interruptSource);
+	m_capacityController = std::move(other.m_capacityController);
 
+	other.m_break.store(true);
 	other.m_pipePath.clear();
+	other.m_readHandle  = -1;
+	other.m_guardHandle = -1;
 
 	return *this;
 }
 
 void NamedPipe::destroy() {
-	m_break.store(true);
+	interrupt();
 
+	// Remove the pipe before closing its reading end, so that writers never find it without a reader (which would
+	// make them wait for one to show up instead of for the pipe to be created again)
 	if (!m_pipePath.empty()) {
 		std::error_code errorCode;
 		std::filesystem::remove(m_pipePath, errorCode);
@@ -221,6 +714,16 @@ void NamedPipe::destroy() {
 
 		m_pipePath.clear();
 	}
+
+	for (int *handle : { &m_readHandle, &m_guardHandle }) {
+		if (*handle != -1) {
+			if (::close(*handle) != 0) {
+				std::cerr << "Failed at closing pipe handle: " << errno << std::endl;
+			}
+
+			*handle = -1;
+		}
+	}
 }
 #endif // PIPE_PLATFORM_UNIX
 
@@ -250,7 +753,7 @@ std::chrono::milliseconds sleepFor(std::chrono::milliseconds duration, bool prec
 }
 
 void waitOnAsyncIO(HANDLE handle, LPOVERLAPPED overlappedPtr, std::chrono::milliseconds &timeout,
-				   const std::atomic_bool &interrupt) {
+				   const std::atomic_bool &interrupt, const StopToken &stopToken = StopToken()) {
 	constexpr std::chrono::milliseconds pendingWaitInterval(1);
 	const bool sleepPrecisely = needsPreciseSleep(timeout);
 
@@ -265,7 +768,7 @@ void waitOnAsyncIO(HANDLE handle, LPOVERLAPPED overlappedPtr, std::chrono::milli
 			throw TimeoutException();
 		}
 
-		if (interrupt) {
+		if (interrupt || stopToken.stop_requested()) {
 			throw InterruptException();
 		}
 
@@ -277,21 +780,24 @@ void waitOnAsyncIO(HANDLE handle, LPOVERLAPPED overlappedPtr, std::chrono::milli
 	}
 }
 
-NamedPipe NamedPipe::create(std::filesystem::path pipePath) {
+NamedPipe NamedPipe::create(std::filesystem::path pipePath, std::size_t capacity) {
 	if (pipePath.parent_path().empty()) {
 		pipePath = std::filesystem::path("\\\\.\\pipe") / pipePath;
 	}
 
 	assert(pipePath.parent_path() == "\\\\.\\pipe");
+	assert(capacity <= (std::numeric_limits< DWORD >::max)());
+
+	const DWORD bufferSize = capacity > 0 ? static_cast< DWORD >(capacity) : PIPE_BUFFER_SIZE;
 
 	HANDLE pipeHandle = CreateNamedPipe(pipePath.string().c_str(),
 										PIPE_ACCESS_INBOUND | FILE_FLAG_OVERLAPPED | FILE_FLAG_FIRST_PIPE_INSTANCE,
 										PIPE_TYPE_BYTE | PIPE_WAIT,
-										1,                // # of allowed pipe instances
-										PIPE_BUFFER_SIZE, // Initial size of outbound buffer
-										PIPE_BUFFER_SIZE, // Initial size of inbound buffer
-										0,                // Use default wait time
-										NULL              // Use default security attributes
+										1,          // # of allowed pipe instances
+										bufferSize, // Initial size of outbound buffer
+										bufferSize, // Initial size of inbound buffer
+										0,          // Use default wait time
+										NULL        // Use default security attributes
 	);
 
 	if (pipeHandle == INVALID_HANDLE_VALUE) {
@@ -366,6 +872,108 @@ void NamedPipe::write(std::filesystem::path pipePath, const std::byte *message,
 	}
 }
 
+/**
+ * Invokes the given (throwing) operation and translates the exceptions it may throw into the corresponding status
+ *
+ * @param operation The operation to perform. Must return the amount of processed bytes.
+ * @returns The outcome of the operation
+ */
+template< typename operation_t > static Result< std::size_t > toResult(operation_t &&operation) noexcept {
+	try {
+		return Result< std::size_t >(Status::Ok, operation());
+	} catch (const TimeoutException &) {
+		return Result< std::size_t >(Status::Timeout);
+	} catch (const InterruptException &) {
+		return Result< std::size_t >(Status::Interrupted);
+	} catch (const PipeException< DWORD > &e) {
+		return Result< std::size_t >(Status::Error, 0, e.errorCode());
+	} catch (...) {
+		return Result< std::size_t >(Status::Error, 0, ERROR_NOT_ENOUGH_MEMORY);
+	}
+}
+
+std::size_t NamedPipe::write_partial(std::filesystem::path pipePath, const std::byte *message,
+									 std::size_t messageSize, std::chrono::milliseconds timeout) {
+	assert(message);
+
+	// WriteFile either writes everything or keeps pending until it does
+	write(std::move(pipePath), message, messageSize, timeout);
+
+	return messageSize;
+}
+
+Result< std::size_t > NamedPipe::try_write(const std::filesystem::path &pipePath, const std::byte *message,
+										   std::size_t messageSize, std::chrono::milliseconds timeout) noexcept {
+	assert(message);
+
+	return toResult([&]() { return write_partial(pipePath, message, messageSize, timeout); });
+}
+
+void NamedPipe::write_gather(std::filesystem::path pipePath, const ConstBuffer *buffers, std::size_t bufferCount,
+							 std::chrono::milliseconds timeout) {
+	assert(buffers || bufferCount == 0);
+
+	// A message has to be written with a single WriteFile call, so there is no way around concatenating the buffers
+	std::vector< std::byte > message;
+	for (std::size_t i = 0; i < bufferCount; ++i) {
+		message.insert(message.end(), buffers[i].data, buffers[i].data + buffers[i].size);
+	}
+
+	write(std::move(pipePath), message.data(), message.size(), timeout);
+}
+
+void NamedPipe::write_zero_copy(std::filesystem::path pipePath, PageAlignedBuffer buffer,
+								std::chrono::milliseconds timeout) {
+	write(std::move(pipePath), buffer.data(), buffer.size(), timeout);
+}
+
+void NamedPipe::write_message(std::filesystem::path pipePath, const std::byte *message, std::size_t messageSize,
+							  std::chrono::milliseconds timeout) {
+	assert(message);
+
+	if (messageSize > FrameHeader::maxLength) {
+		throw FramingException();
+	}
+
+	// The frame has to be sent with a single WriteFile call, so header and payload have to be joined first
+	std::vector< std::byte > frame(FrameHeader::size + messageSize);
+	FrameHeader{ 0, static_cast< std::uint32_t >(messageSize) }.encode(frame.data());
+	std::copy(message, message + messageSize, frame.begin() + FrameHeader::size);
+
+	write(std::move(pipePath), frame.data(), frame.size(), timeout);
+}
+
+std::size_t NamedPipe::write_many(std::filesystem::path pipePath, const ConstBuffer *messages,
+								 std::size_t messageCount, std::chrono::milliseconds timeout) {
+	assert(messages || messageCount == 0);
+
+	const Deadline deadline(timeout);
+
+	// Every message has to be written separately anyway, as the server end disconnects after each read
+	for (std::size_t i = 0; i < messageCount; ++i) {
+		try {
+			write_message(pipePath, messages[i].data, messages[i].size, deadline.remaining());
+		} catch (const TimeoutException &) {
+			if (i == 0) {
+				throw;
+			}
+
+			return i;
+		}
+	}
+
+	return messageCount;
+}
+
+std::size_t NamedPipe::getCapacity() const {
+	DWORD inBufferSize = 0;
+	if (!GetNamedPipeInfo(m_handle, NULL, NULL, &inBufferSize, NULL)) {
+		return 0;
+	}
+
+	return inBufferSize;
+}
+
 // Implementation from https://stackoverflow.com/a/66588424/3907364
 bool NamedPipe::exists(const std::filesystem::path &pipePath) {
 	std::string pipeName = pipePath.string();
@@ -403,7 +1011,8 @@ bool NamedPipe::exists(const std::filesystem::path &pipePath) {
 }
 
 void disconnectAndReconnect(HANDLE pipeHandle, LPOVERLAPPED overlappedPtr, bool disconnectFirst,
-							std::chrono::milliseconds &timeout, const std::atomic_bool &interrupt) {
+							std::chrono::milliseconds &timeout, const std::atomic_bool &interrupt,
+							const StopToken &stopToken) {
 	if (disconnectFirst) {
 		if (!DisconnectNamedPipe(pipeHandle)) {
 			throw PipeException< DWORD >(GetLastError(), "Disconnect");
@@ -414,7 +1023,7 @@ void disconnectAndReconnect(HANDLE pipeHandle, LPOVERLAPPED overlappedPtr, bool
 		switch (GetLastError()) {
 			case ERROR_IO_PENDING:
 				// There is no client connected yet
-				waitOnAsyncIO(pipeHandle, overlappedPtr, timeout, interrupt);
+				waitOnAsyncIO(pipeHandle, overlappedPtr, timeout, interrupt, stopToken);
 
 				return;
 			case ERROR_NO_DATA:
@@ -430,9 +1039,12 @@ void disconnectAndReconnect(HANDLE pipeHandle, LPOVERLAPPED overlappedPtr, bool
 	}
 }
 
-std::vector< std::byte > NamedPipe::read_blocking(std::chrono::milliseconds timeout) const {
-	std::vector< std::byte > message;
-
+/**
+ * Reads the next message from the given pipe into the given container
+ */
+template< typename container_t >
+static void readBlocking(HANDLE pipeHandle, const std::atomic_bool &interrupt, container_t &message,
+						 std::chrono::milliseconds timeout, const StopToken &stopToken) {
 	const bool sleepPrecisely = needsPreciseSleep(timeout);
 
 	OVERLAPPED overlapped;
@@ -442,7 +1054,7 @@ std::vector< std::byte > NamedPipe::read_blocking(std::chrono::milliseconds time
 	overlapped.hEvent = eventHandle;
 
 	// Connect to pipe
-	disconnectAndReconnect(m_handle, &overlapped, false, timeout, m_break);
+	disconnectAndReconnect(pipeHandle, &overlapped, false, timeout, interrupt, stopToken);
 
 	// Reset overlapped structure
 	memset(&overlapped, 0, sizeof(OVERLAPPED));
@@ -453,11 +1065,11 @@ std::vector< std::byte > NamedPipe::read_blocking(std::chrono::milliseconds time
 	// Loop until we explicitly break from it (because we're done reading)
 	while (true) {
 		DWORD readBytes = 0;
-		BOOL success    = ReadFile(m_handle, buffer.data(), PIPE_BUFFER_SIZE, &readBytes, &overlapped);
+		BOOL success    = ReadFile(pipeHandle, buffer.data(), PIPE_BUFFER_SIZE, &readBytes, &overlapped);
 		if (!success && GetLastError() == ERROR_IO_PENDING) {
 			// Wait for the async IO to complete (note that the thread can't be
 			// interrupted while waiting this way)
-			success = GetOverlappedResult(m_handle, &overlapped, &readBytes, TRUE);
+			success = GetOverlappedResult(pipeHandle, &overlapped, &readBytes, TRUE);
 
 			if (!success && GetLastError() != ERROR_BROKEN_PIPE) {
 				throw PipeException< DWORD >(GetLastError(), "Overlapped waiting");
@@ -485,7 +1097,7 @@ std::vector< std::byte > NamedPipe::read_blocking(std::chrono::milliseconds time
 					memset(&overlapped, 0, sizeof(OVERLAPPED));
 					overlapped.hEvent = eventHandle;
 
-					disconnectAndReconnect(m_handle, &overlapped, true, timeout, m_break);
+					disconnectAndReconnect(pipeHandle, &overlapped, true, timeout, interrupt, stopToken);
 
 					// Reset overlapped structure
 					memset(&overlapped, 0, sizeof(OVERLAPPED));
@@ -507,19 +1119,110 @@ std::vector< std::byte > NamedPipe::read_blocking(std::chrono::milliseconds time
 		}
 	}
 
-	DisconnectNamedPipe(m_handle);
+	DisconnectNamedPipe(pipeHandle);
+}
+
+std::vector< std::byte > NamedPipe::read_blocking(std::chrono::milliseconds timeout,
+												  const StopToken &stopToken) const {
+	std::vector< std::byte > message;
+
+	readBlocking(m_handle, m_break, message, timeout, stopToken);
 
 	return message;
 }
 
-NamedPipe::NamedPipe(NamedPipe &&other) : m_pipePath(std::move(other.m_pipePath)), m_handle(other.m_handle) {
+#	ifdef __cpp_lib_memory_resource
+std::pmr::vector< std::byte > NamedPipe::read_blocking(std::pmr::memory_resource *resource,
+													   std::chrono::milliseconds timeout,
+													   const StopToken &stopToken) const {
+	std::pmr::vector< std::byte > message(resource);
+
+	readBlocking(m_handle, m_break, message, timeout, stopToken);
+
+	return message;
+}
+#	endif
+
+Message NamedPipe::read_blocking(BufferPool &pool, std::chrono::milliseconds timeout,
+								 const StopToken &stopToken) const {
+	const std::vector< std::byte > content = read_blocking(timeout, stopToken);
+
+	Message message = pool.acquire(content.size());
+	std::copy(content.begin(), content.end(), message.begin());
+
+	return message;
+}
+
+std::size_t NamedPipe::read_into(std::byte *buffer, std::size_t bufferSize, std::chrono::milliseconds timeout,
+								 const StopToken &stopToken) const {
+	assert(buffer);
+
+	if (m_unread.empty()) {
+		m_unread = read_blocking(timeout, stopToken);
+	}
+
+	// Whatever doesn't fit into the buffer is kept for the next call
+	const std::size_t readBytes = (std::min)(bufferSize, m_unread.size());
+	std::copy(m_unread.begin(), m_unread.begin() + readBytes, buffer);
+	m_unread.erase(m_unread.begin(), m_unread.begin() + readBytes);
+
+	return readBytes;
+}
+
+Result< std::size_t > NamedPipe::try_read(std::byte *buffer, std::size_t bufferSize, std::chrono::milliseconds timeout,
+										  const StopToken &stopToken) const noexcept {
+	assert(buffer);
+
+	return toResult([&]() { return read_into(buffer, bufferSize, timeout, stopToken); });
+}
+
+std::vector< std::byte > NamedPipe::read_message(std::chrono::milliseconds timeout,
+												 const StopToken &stopToken) const {
+	std::vector< std::byte > message;
+
+	const Deadline deadline(timeout);
+
+	while (!m_decoder.next(message)) {
+		const std::vector< std::byte > content = read_blocking(deadline.remaining(), stopToken);
+
+		m_decoder.feed(content.data(), content.size());
+	}
+
+	return message;
+}
+
+std::size_t NamedPipe::read_batch(MessageBatch &batch, std::chrono::milliseconds timeout,
+								 const StopToken &stopToken) const {
+	batch.clear();
+
+	const Deadline deadline(timeout);
+
+	while (true) {
+		while (m_decoder.next(batch)) {
+		}
+
+		if (!batch.empty()) {
+			return batch.size();
+		}
+
+		const std::vector< std::byte > content = read_blocking(deadline.remaining(), stopToken);
+
+		m_decoder.feed(content.data(), content.size());
+	}
+}
+
+NamedPipe::NamedPipe(NamedPipe &&other)
+	: m_pipePath(std::move(other.m_pipePath)), m_decoder(std::move(other.m_decoder)), m_handle(other.m_handle),
+	  m_unread(std::move(other.m_unread)) {
 	other.m_pipePath.clear();
 	other.m_handle = INVALID_HANDLE_VALUE;
 }
 
 NamedPipe &NamedPipe::operator=(NamedPipe &&other) {
 	m_pipePath = std::move(other.m_pipePath);
+	m_decoder  = std::move(other.m_decoder);
 	m_handle   = other.m_handle;
+	m_unread   = std::move(other.m_unread);
 	m_break.store(other.m_break.load());
 
 	other.m_break.store(true);
@@ -0,0 +1,108 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// source tree or at
+// <https://github.com/Krzmbrzl/NamedPipe/blob/main/LICENSE>.
+
+#include "npipe/PageAlignedBuffer.hpp"
+
+#ifdef PIPE_PLATFORM_UNIX
+#	include <sys/mman.h>
+#	include <unistd.h>
+#endif
+
+#ifdef PIPE_PLATFORM_WINDOWS
+#	include <windows.h>
+#endif
+
+#include <new>
+#include <utility>
+
+namespace npipe {
+
+#ifdef PIPE_PLATFORM_UNIX
+std::size_t PageAlignedBuffer::pageSize() noexcept {
+	static const std::size_t size = static_cast< std::size_t >(::sysconf(_SC_PAGESIZE));
+
+	return size;
+}
+
+static std::byte *allocatePages(std::size_t size) {
+	// Anonymous mappings are page-aligned and zero-filled by definition
+	void *buffer = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+	if (buffer == MAP_FAILED) {
+		throw std::bad_alloc();
+	}
+
+	return static_cast< std::byte * >(buffer);
+}
+
+static void freePages(std::byte *buffer, std::size_t size) noexcept {
+	// Pages that have been spliced into a pipe are kept alive by the pipe until they have been read
+	::munmap(buffer, size);
+}
+#endif
+
+#ifdef PIPE_PLATFORM_WINDOWS
+std::size_t PageAlignedBuffer::pageSize() noexcept {
+	static const std::size_t size = []() {
+		SYSTEM_INFO info;
+		GetSystemInfo(&info);
+
+		return static_cast< std::size_t >(info.dwPageSize);
+	}();
+
+	return size;
+}
+
+static std::byte *allocatePages(std::size_t size) {
+	void *buffer = VirtualAlloc(nullptr, size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+
+	if (!buffer) {
+		throw std::bad_alloc();
+	}
+
+	return static_cast< std::byte * >(buffer);
+}
+
+static void freePages(std::byte *buffer, std::size_t) noexcept {
+	VirtualFree(buffer, 0, MEM_RELEASE);
+}
+#endif
+
+PageAlignedBuffer::PageAlignedBuffer(std::size_t size) : m_size(size) {
+	if (size == 0) {
+		return;
+	}
+
+	const std::size_t page = pageSize();
+	m_capacity             = (size + page - 1) / page * page;
+	m_buffer               = allocatePages(m_capacity);
+}
+
+PageAlignedBuffer::~PageAlignedBuffer() {
+	if (m_buffer) {
+		freePages(m_buffer, m_capacity);
+	}
+}
+
+PageAlignedBuffer::PageAlignedBuffer(PageAlignedBuffer &&other) noexcept
+	: m_buffer(std::exchange(other.m_buffer, nullptr)), m_size(std::exchange(other.m_size, 0)),
+	  m_capacity(std::exchange(other.m_capacity, 0)) {
+}
+
+PageAlignedBuffer &PageAlignedBuffer::operator=(PageAlignedBuffer &&other) noexcept {
+	if (this != &other) {
+		if (m_buffer) {
+			freePages(m_buffer, m_capacity);
+		}
+
+		m_buffer   = std::exchange(other.m_buffer, nullptr);
+		m_size     = std::exchange(other.m_size, 0);
+		m_capacity = std::exchange(other.m_capacity, 0);
+	}
+
+	return *this;
+}
+
+} // namespace npipe
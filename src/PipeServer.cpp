@@ -0,0 +1,118 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// source tree or at
+// <https://github.com/Krzmbrzl/NamedPipe/blob/main/LICENSE>.
+
+#include "npipe/PipeServer.hpp"
+#include "npipe/InterruptException.hpp"
+
+#include "WorkStealingPool.hpp"
+
+#include <chrono>
+#include <limits>
+#include <utility>
+
+namespace npipe {
+
+PipeServer::PipeServer(const NamedPipe &pipe, handler_t handler, key_function_t keyOf, PipeServerOptions options)
+	: m_pipe(pipe), m_handler(std::move(handler)), m_keyOf(std::move(keyOf)),
+	  m_pool(std::make_unique< WorkStealingPool >(options.threadCount)), m_threadCount(m_pool->size()) {
+	m_reader = std::thread([this]() { runReader(); });
+}
+
+PipeServer::~PipeServer() {
+	shutdown();
+}
+
+void PipeServer::stop() {
+	shutdown();
+
+	if (m_error) {
+		std::rethrow_exception(std::exchange(m_error, nullptr));
+	}
+}
+
+std::size_t PipeServer::threadCount() const noexcept {
+	return m_threadCount;
+}
+
+void PipeServer::shutdown() noexcept {
+	m_stopSource.request_stop();
+
+	if (m_reader.joinable()) {
+		m_reader.join();
+	}
+
+	if (m_pool) {
+		// Strands keep submitting their follow-up tasks while the queued tasks are run, so the pool has to stay
+		// around until it has been drained
+		m_pool->stop();
+		m_pool.reset();
+	}
+}
+
+void PipeServer::runReader() {
+	const StopToken stopToken = m_stopSource.get_token();
+	MessageBatch batch;
+
+	while (true) {
+		try {
+			m_pipe.read_batch(batch, std::chrono::milliseconds{ (std::numeric_limits< unsigned int >::max)() },
+							  stopToken);
+		} catch (const InterruptException &) {
+			return;
+		} catch (...) {
+			m_error = std::current_exception();
+			return;
+		}
+
+		for (ConstBuffer message : batch) {
+			dispatch(std::vector< std::byte >(message.data, message.data + message.size));
+		}
+	}
+}
+
+void PipeServer::dispatch(std::vector< std::byte > message) {
+	const std::optional< std::uint64_t > key = m_keyOf ? m_keyOf(message) : std::nullopt;
+
+	if (!key) {
+		m_pool->submit([this, message = std::move(message)]() mutable { m_handler(std::move(message)); });
+		return;
+	}
+
+	std::lock_guard< std::mutex > guard(m_strandMutex);
+
+	std::deque< std::vector< std::byte > > &strand = m_strands[*key];
+	strand.push_back(std::move(message));
+
+	if (strand.size() == 1) {
+		// The strand has been idle -> get it going again
+		m_pool->submit([this, key]() { runStrand(*key); });
+	}
+}
+
+void PipeServer::runStrand(std::uint64_t key) {
+	std::vector< std::byte > message;
+	{
+		std::lock_guard< std::mutex > guard(m_strandMutex);
+
+		// Leave the (now empty) message in place, so that the strand is considered busy while it is being handled
+		message = std::move(m_strands[key].front());
+	}
+
+	m_handler(std::move(message));
+
+	std::lock_guard< std::mutex > guard(m_strandMutex);
+
+	auto it = m_strands.find(key);
+	it->second.pop_front();
+
+	if (it->second.empty()) {
+		m_strands.erase(it);
+	} else {
+		// Handle the next message in a separate task, so that other work gets its turn in between
+		m_pool->submit([this, key]() { runStrand(key); });
+	}
+}
+
+} // namespace npipe
@@ -0,0 +1,646 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// source tree or at
+// <https://github.com/Krzmbrzl/NamedPipe/blob/main/LICENSE>.
+
+#include "npipe/PipeWriter.hpp"
+#include "npipe/Framing.hpp"
+#include "npipe/FramingException.hpp"
+#include "npipe/NamedPipe.hpp"
+#include "npipe/PipeException.hpp"
+#include "npipe/TimeoutException.hpp"
+
+#ifdef PIPE_PLATFORM_UNIX
+#	include "Deadline.hpp"
+#	include "PosixUtils.hpp"
+
+#	include <climits>
+#	include <fcntl.h>
+#	include <sys/uio.h>
+#	include <unistd.h>
+#endif
+
+#ifdef PIPE_PLATFORM_WINDOWS
+#	include <windows.h>
+#endif
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cerrno>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <new>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace npipe {
+
+#ifdef PIPE_PLATFORM_UNIX
+/**
+ * The minimum amount of pages a buffer has to span for write_zero_copy to actually avoid copying it. For smaller
+ * buffers, the overhead of mapping the pages into the pipe outweighs the cost of copying them.
+ */
+constexpr std::size_t ZERO_COPY_THRESHOLD = 4;
+
+/**
+ * The maximum amount of frames that are grouped into a single write by write_many
+ */
+constexpr std::size_t MAX_BATCH_GROUP_SIZE = 32;
+#endif
+
+PipeWriter::PipeWriter(std::filesystem::path pipePath) : m_pipePath(std::move(pipePath)) {
+}
+
+PipeWriter::~PipeWriter() {
+	disconnect();
+}
+
+std::filesystem::path PipeWriter::getPath() const noexcept {
+	return m_pipePath;
+}
+
+PipeWriter::operator bool() const noexcept {
+	return !m_pipePath.empty();
+}
+
+void PipeWriter::setFrameGracePeriod(std::chrono::milliseconds gracePeriod) noexcept {
+	m_frameGracePeriod = gracePeriod;
+}
+
+std::chrono::milliseconds PipeWriter::getFrameGracePeriod() const noexcept {
+	return m_frameGracePeriod;
+}
+
+
+#ifdef PIPE_PLATFORM_UNIX
+PipeWriter::PipeWriter(PipeWriter &&other) noexcept
+	: m_pipePath(std::move(other.m_pipePath)), m_frameGracePeriod(other.m_frameGracePeriod), m_handle(other.m_handle) {
+	other.m_pipePath.clear();
+	other.m_handle = -1;
+}
+
+PipeWriter &PipeWriter::operator=(PipeWriter &&other) noexcept {
+	if (this != &other) {
+		disconnect();
+
+		m_pipePath         = std::move(other.m_pipePath);
+		m_frameGracePeriod = other.m_frameGracePeriod;
+		m_handle           = other.m_handle;
+
+		other.m_pipePath.clear();
+		other.m_handle = -1;
+	}
+
+	return *this;
+}
+
+/**
+ * Performs a transfer through the given connection. If the reading end goes away, the connection is re-established
+ * and the transfer is started over.
+ *
+ * @param handle The connection to use. -1 if currently not connected.
+ * @param pipePath The path of the pipe to (re)connect to
+ * @param deadline The point in time at which to give up
+ * @param transfer A function with the signature Status(int handle, std::size_t &written) that performs the transfer
+ * from the beginning
+ * @returns The result of the final transfer attempt, carrying the amount of bytes that have been committed to the
+ * pipe. If no reader could be reached before the deadline, the status is Status::Closed.
+ */
+template< typename transfer_t >
+static Result< std::size_t > transferReconnecting(int &handle, const std::filesystem::path &pipePath,
+												  const Deadline &deadline, transfer_t &&transfer) {
+	// Make sure a vanished reader results in EPIPE rather than in our process being killed
+	SigPipeGuard sigPipeGuard;
+
+	while (true) {
+		if (handle == -1) {
+			handle = openForWriting(pipePath, deadline);
+
+			if (handle == -1) {
+				return Result< std::size_t >(Status::Closed, 0, ENXIO);
+			}
+		}
+
+		std::size_t written = 0;
+		const Status status = transfer(handle, written);
+
+		if (status == Status::Error && (errno == EPIPE || errno == ENXIO)) {
+			if (errno == EPIPE) {
+				noteBrokenPipe();
+			}
+
+			// The reading end has gone away (and with it anything we might have written already) -> drop the stale
+			// connection and start over once the reader is back
+			::close(handle);
+			handle = -1;
+			continue;
+		}
+
+		return Result< std::size_t >(status, written, status == Status::Error ? errno : 0);
+	}
+}
+
+/**
+ * Writes the given buffers through the given connection, reconnecting if needed (see transferReconnecting)
+ *
+ * @param handle The connection to use. -1 if currently not connected.
+ * @param pipePath The path of the pipe to (re)connect to
+ * @param buffers The buffers to write
+ * @param bufferCount The amount of buffers
+ * @param deadline The point in time at which to give up
+ * @param zeroCopy Whether to gift the (page-aligned) buffers to the kernel instead of copying them (Linux only)
+ * @returns The result of the final write attempt
+ */
+static Result< std::size_t > writeReconnecting(int &handle, const std::filesystem::path &pipePath,
+											   const iovec *buffers, std::size_t bufferCount,
+											   const Deadline &deadline, bool zeroCopy = false) {
+	// writeAll modifies the buffers it is given, so we have to work on a copy
+	constexpr std::size_t localBufferCount = 8;
+	std::array< iovec, localBufferCount > localBuffers;
+	std::vector< iovec > heapBuffers;
+
+	return transferReconnecting(handle, pipePath, deadline, [&](int connection, std::size_t &written) {
+		iovec *pending;
+		if (bufferCount <= localBufferCount) {
+			std::copy(buffers, buffers + bufferCount, localBuffers.begin());
+			pending = localBuffers.data();
+		} else {
+			heapBuffers.assign(buffers, buffers + bufferCount);
+			pending = heapBuffers.data();
+		}
+
+#	ifdef __linux__
+		return zeroCopy ? spliceAll(connection, pending, bufferCount, deadline, written, true)
+						: writeAll(connection, pending, bufferCount, deadline, written);
+#	else
+		(void) zeroCopy;
+		return writeAll(connection, pending, bufferCount, deadline, written);
+#	endif
+	});
+}
+
+/**
+ * Writes the remainder of a frame of which only the beginning made it into the pipe before the deadline passed. A
+ * torn frame would make the reader misinterpret everything written after it, so once the first byte of a frame is
+ * out, the frame is finished past the original deadline (bounded by the writer's frame grace period).
+ *
+ * @param handle The connection the frame's beginning has been written to
+ * @param header The encoded frame header
+ * @param payload The frame's payload
+ * @param alreadyWritten The amount of the frame's bytes (including the header) that have been written already
+ * @param deadline The point in time at which to give up on the frame
+ * @param[in,out] written Incremented by the amount of bytes that have been written
+ * @returns Status::Ok once the frame is complete, Status::Timeout if the reader didn't make room in time or
+ * Status::Error if the connection failed (errno holds the cause). In the latter two cases the connection has to be
+ * dropped, as the frame remains torn.
+ */
+static Status finishFrame(int handle, const std::byte *header, const ConstBuffer &payload, std::size_t alreadyWritten,
+						  const Deadline &deadline, std::size_t &written) noexcept {
+	const std::size_t headerWritten  = (std::min)(alreadyWritten, FrameHeader::size);
+	const std::size_t payloadWritten = alreadyWritten - headerWritten;
+	assert(payloadWritten <= payload.size);
+
+	std::array< iovec, 2 > remainder = { { { const_cast< std::byte * >(header) + headerWritten,
+											  FrameHeader::size - headerWritten },
+											{ const_cast< std::byte * >(payload.data) + payloadWritten,
+											  payload.size - payloadWritten } } };
+
+	return writeAll(handle, remainder.data(), remainder.size(), deadline, written);
+}
+
+/**
+ * Turns the result of a write into the corresponding exception (if it doesn't indicate success)
+ *
+ * @param result The result of the write
+ * @param allowPartial Whether running out of time after having connected to the pipe is acceptable
+ * @returns The amount of bytes that have been written
+ */
+static std::size_t unwrapWrite(const Result< std::size_t > &result, bool allowPartial) {
+	if (result.status() == Status::Closed) {
+		// There was no reader to connect to in time
+		throw TimeoutException();
+	}
+
+	if (allowPartial && result.status() == Status::Timeout) {
+		return result.value();
+	}
+
+	return unwrap(result, "Write");
+}
+
+void PipeWriter::write(const std::byte *message, std::size_t messageSize, std::chrono::milliseconds timeout) {
+	assert(message);
+
+	unwrapWrite(try_write(message, messageSize, timeout), false);
+}
+
+std::size_t PipeWriter::write_partial(const std::byte *message, std::size_t messageSize,
+									  std::chrono::milliseconds timeout) {
+	assert(message);
+
+	return unwrapWrite(try_write(message, messageSize, timeout), true);
+}
+
+Result< std::size_t > PipeWriter::try_write(const std::byte *message, std::size_t messageSize,
+											std::chrono::milliseconds timeout) noexcept {
+	assert(message);
+
+	const iovec buffer = { const_cast< std::byte * >(message), messageSize };
+
+	return writeReconnecting(m_handle, m_pipePath, &buffer, 1, Deadline(timeout));
+}
+
+void PipeWriter::write_gather(const ConstBuffer *buffers, std::size_t bufferCount, std::chrono::milliseconds timeout) {
+	assert(buffers || bufferCount == 0);
+
+	unwrapWrite(try_write_gather(buffers, bufferCount, timeout), false);
+}
+
+Result< std::size_t > PipeWriter::try_write_gather(const ConstBuffer *buffers, std::size_t bufferCount,
+												   std::chrono::milliseconds timeout) noexcept {
+	assert(buffers || bufferCount == 0);
+
+	constexpr std::size_t localBufferCount = 8;
+	std::array< iovec, localBufferCount > localVectors;
+	std::vector< iovec > heapVectors;
+
+	iovec *vectors = localVectors.data();
+	if (bufferCount > localBufferCount) {
+		try {
+			heapVectors.resize(bufferCount);
+		} catch (const std::bad_alloc &) {
+			return Result< std::size_t >(Status::Error, 0, ENOMEM);
+		}
+
+		vectors = heapVectors.data();
+	}
+
+	std::transform(buffers, buffers + bufferCount, vectors, [](const ConstBuffer &current) {
+		return iovec{ const_cast< std::byte * >(current.data), current.size };
+	});
+
+	// As long as everything is submitted with a single writev, messages of up to PIPE_BUF bytes are written atomically
+	return writeReconnecting(m_handle, m_pipePath, vectors, bufferCount, Deadline(timeout));
+}
+
+void PipeWriter::write_message(const std::byte *message, std::size_t messageSize, std::chrono::milliseconds timeout) {
+	assert(message);
+
+	if (messageSize > FrameHeader::maxLength) {
+		throw FramingException();
+	}
+
+	std::array< std::byte, FrameHeader::size > header;
+	FrameHeader{ 0, static_cast< std::uint32_t >(messageSize) }.encode(header.data());
+
+	// Write header and payload in one go so that (small) frames end up in the pipe atomically
+	const std::array< iovec, 2 > buffers = { { { header.data(), header.size() },
+											   { const_cast< std::byte * >(message), messageSize } } };
+
+	Result< std::size_t > result =
+		writeReconnecting(m_handle, m_pipePath, buffers.data(), buffers.size(), Deadline(timeout));
+
+	if (result.status() == Status::Timeout && result.value() > 0) {
+		// The reader may go away while we are finishing the frame
+		SigPipeGuard sigPipeGuard;
+
+		std::size_t finished = 0;
+		const Status status  = finishFrame(m_handle, header.data(), { message, messageSize }, result.value(),
+										   Deadline(m_frameGracePeriod), finished);
+		const int errorCode  = status == Status::Error ? errno : 0;
+
+		if (errorCode == EPIPE) {
+			noteBrokenPipe();
+		}
+
+		result = Result< std::size_t >(status, result.value() + finished, errorCode);
+
+		if (status != Status::Ok) {
+			// Rather than appending the next frame to the torn one, end the stream here
+			disconnect();
+		}
+	}
+
+	unwrapWrite(result, false);
+}
+
+void PipeWriter::write_zero_copy(PageAlignedBuffer buffer, std::chrono::milliseconds timeout) {
+	const iovec pages = { buffer.data(), buffer.size() };
+
+	// Mapping pages into the pipe only pays off if there are enough of them
+	const bool zeroCopy = buffer.size() >= ZERO_COPY_THRESHOLD * PageAlignedBuffer::pageSize();
+
+	unwrapWrite(writeReconnecting(m_handle, m_pipePath, &pages, 1, Deadline(timeout), zeroCopy), false);
+}
+
+std::size_t PipeWriter::write_file(int fd, std::uint64_t offset, std::size_t length,
+								  std::chrono::milliseconds timeout) {
+	const Deadline deadline(timeout);
+
+	return unwrapWrite(transferReconnecting(m_handle, m_pipePath, deadline,
+											[&](int connection, std::size_t &written) {
+												return writeFileRange(connection, fd, offset, length, deadline, written);
+											}),
+					   true);
+}
+
+std::size_t PipeWriter::write_file(const std::filesystem::path &filePath, std::uint64_t offset, std::size_t length,
+								  std::chrono::milliseconds timeout) {
+	const int file = ::open(filePath.c_str(), O_RDONLY | O_CLOEXEC);
+	if (file == -1) {
+		throw PipeException< int >(errno, "Open file");
+	}
+
+	std::size_t written;
+	try {
+		written = write_file(file, offset, length, timeout);
+	} catch (...) {
+		::close(file);
+		throw;
+	}
+
+	::close(file);
+
+	return written;
+}
+
+std::size_t PipeWriter::write_many(const ConstBuffer *messages, std::size_t messageCount,
+								  std::chrono::milliseconds timeout) {
+	assert(messages || messageCount == 0);
+
+	if (std::any_of(messages, messages + messageCount, [](const ConstBuffer &current) {
+			return current.size > FrameHeader::maxLength;
+		})) {
+		throw FramingException();
+	}
+
+	const Deadline deadline(timeout);
+	std::size_t completed = 0;
+	bool torn             = false;
+
+	const Result< std::size_t > result =
+		transferReconnecting(m_handle, m_pipePath, deadline, [&](int connection, std::size_t &written) {
+			// Everything that has been written during a previous attempt has been lost with the previous reader
+			completed = 0;
+			torn      = false;
+
+			std::array< std::byte, MAX_BATCH_GROUP_SIZE * FrameHeader::size > headers;
+			std::array< iovec, 2 * MAX_BATCH_GROUP_SIZE > vectors;
+
+			while (completed < messageCount) {
+				// Collect as many frames as can be written atomically in one go
+				std::size_t groupSize  = 0;
+				std::size_t groupBytes = 0;
+				do {
+					const ConstBuffer &current = messages[completed + groupSize];
+					const std::size_t frameSize = FrameHeader::size + current.size;
+
+					if (groupSize > 0 && groupBytes + frameSize > PIPE_BUF) {
+						break;
+					}
+
+					std::byte *header = headers.data() + groupSize * FrameHeader::size;
+					FrameHeader{ 0, static_cast< std::uint32_t >(current.size) }.encode(header);
+
+					vectors[2 * groupSize]     = { header, FrameHeader::size };
+					vectors[2 * groupSize + 1] = { const_cast< std::byte * >(current.data), current.size };
+
+					groupBytes += frameSize;
+					++groupSize;
+				} while (groupSize < MAX_BATCH_GROUP_SIZE && completed + groupSize < messageCount);
+
+				std::size_t groupWritten = 0;
+				const Status status      = writeAll(connection, vectors.data(), 2 * groupSize, deadline, groupWritten);
+				written += groupWritten;
+
+				if (status != Status::Ok) {
+					// Only the frames that made it into the pipe completely count as written
+					std::size_t groupIndex = 0;
+					for (; groupIndex < groupSize; ++groupIndex) {
+						const std::size_t frameSize = FrameHeader::size + messages[completed].size;
+						if (groupWritten < frameSize) {
+							break;
+						}
+
+						groupWritten -= frameSize;
+						++completed;
+					}
+
+					if (status == Status::Timeout && groupWritten > 0) {
+						const Status finishStatus =
+							finishFrame(connection, headers.data() + groupIndex * FrameHeader::size,
+										messages[completed], groupWritten, Deadline(m_frameGracePeriod), written);
+
+						if (finishStatus != Status::Ok) {
+							torn = true;
+							return finishStatus;
+						}
+
+						++completed;
+					}
+
+					return status;
+				}
+
+				completed += groupSize;
+			}
+
+			return Status::Ok;
+		});
+
+	if (torn) {
+		// Rather than appending the next frame to the torn one, end the stream here
+		disconnect();
+	}
+
+	return unwrapWrite(Result< std::size_t >(result.status(), completed, result.errorCode()), true);
+}
+
+std::size_t PipeWriter::setCapacity(std::size_t capacity, std::chrono::milliseconds timeout) {
+	connect(Deadline(timeout));
+
+	const std::optional< std::size_t > resulting = resizePipe(m_handle, capacity);
+
+	if (!resulting) {
+		throw PipeException< int >(errno, "Resize");
+	}
+
+	return *resulting;
+}
+
+std::size_t PipeWriter::getCapacity(std::chrono::milliseconds timeout) {
+	connect(Deadline(timeout));
+
+	return pipeCapacity(m_handle).value_or(0);
+}
+
+WriteAwaitable PipeWriter::async_write(Reactor &reactor, const std::byte *message, std::size_t messageSize,
+									   std::chrono::milliseconds timeout, StopToken stopToken) {
+	assert(message);
+
+	return WriteAwaitable(*this, reactor, message, messageSize, timeout, std::move(stopToken));
+}
+
+int PipeWriter::native_handle() const noexcept {
+	return m_handle;
+}
+
+void PipeWriter::connect(const Deadline &deadline) {
+	if (m_handle == -1) {
+		m_handle = openForWriting(m_pipePath, deadline);
+
+		if (m_handle == -1) {
+			throw TimeoutException();
+		}
+	}
+}
+
+bool PipeWriter::try_connect(std::chrono::milliseconds timeout) noexcept {
+	if (m_handle == -1) {
+		m_handle = openForWriting(m_pipePath, Deadline(timeout));
+	}
+
+	return m_handle != -1;
+}
+
+void PipeWriter::disconnect() noexcept {
+	if (m_handle != -1) {
+		if (::close(m_handle) != 0) {
+			std::cerr << "Failed at closing pipe writer handle" << std::endl;
+		}
+
+		m_handle = -1;
+	}
+}
+
+bool PipeWriter::isConnected() const noexcept {
+	return m_handle != -1;
+}
+#endif // PIPE_PLATFORM_UNIX
+
+#ifdef PIPE_PLATFORM_WINDOWS
+PipeWriter::PipeWriter(PipeWriter &&other) noexcept
+	: m_pipePath(std::move(other.m_pipePath)), m_frameGracePeriod(other.m_frameGracePeriod) {
+	other.m_pipePath.clear();
+}
+
+PipeWriter &PipeWriter::operator=(PipeWriter &&other) noexcept {
+	m_pipePath         = std::move(other.m_pipePath);
+	m_frameGracePeriod = other.m_frameGracePeriod;
+
+	other.m_pipePath.clear();
+
+	return *this;
+}
+
+void PipeWriter::write(const std::byte *message, std::size_t messageSize, std::chrono::milliseconds timeout) {
+	assert(message);
+
+	// The server end of a Windows pipe disconnects its client after every read, so there is no connection that
+	// could be kept alive across writes
+	NamedPipe::write(m_pipePath, message, messageSize, timeout);
+}
+
+std::size_t PipeWriter::write_partial(const std::byte *message, std::size_t messageSize,
+									  std::chrono::milliseconds timeout) {
+	assert(message);
+
+	return NamedPipe::write_partial(m_pipePath, message, messageSize, timeout);
+}
+
+Result< std::size_t > PipeWriter::try_write(const std::byte *message, std::size_t messageSize,
+											std::chrono::milliseconds timeout) noexcept {
+	assert(message);
+
+	return NamedPipe::try_write(m_pipePath, message, messageSize, timeout);
+}
+
+void PipeWriter::write_gather(const ConstBuffer *buffers, std::size_t bufferCount, std::chrono::milliseconds timeout) {
+	assert(buffers || bufferCount == 0);
+
+	NamedPipe::write_gather(m_pipePath, buffers, bufferCount, timeout);
+}
+
+Result< std::size_t > PipeWriter::try_write_gather(const ConstBuffer *buffers, std::size_t bufferCount,
+												   std::chrono::milliseconds timeout) noexcept {
+	assert(buffers || bufferCount == 0);
+
+	// A message has to be written with a single WriteFile call, so there is no way around concatenating the buffers
+	std::vector< std::byte > message;
+	try {
+		for (std::size_t i = 0; i < bufferCount; ++i) {
+			message.insert(message.end(), buffers[i].data, buffers[i].data + buffers[i].size);
+		}
+	} catch (const std::bad_alloc &) {
+		return Result< std::size_t >(Status::Error, 0, ERROR_NOT_ENOUGH_MEMORY);
+	}
+
+	return NamedPipe::try_write(m_pipePath, message.data(), message.size(), timeout);
+}
+
+void PipeWriter::write_message(const std::byte *message, std::size_t messageSize, std::chrono::milliseconds timeout) {
+	assert(message);
+
+	NamedPipe::write_message(m_pipePath, message, messageSize, timeout);
+}
+
+void PipeWriter::write_zero_copy(PageAlignedBuffer buffer, std::chrono::milliseconds timeout) {
+	write(buffer.data(), buffer.size(), timeout);
+}
+
+std::size_t PipeWriter::write_file(const std::filesystem::path &filePath, std::uint64_t offset, std::size_t length,
+								  std::chrono::milliseconds timeout) {
+	std::ifstream file(filePath, std::ios::binary);
+	if (!file) {
+		throw PipeException< DWORD >(ERROR_FILE_NOT_FOUND, "Open file");
+	}
+
+	file.seekg(0, std::ios::end);
+	const std::uint64_t fileSize = static_cast< std::uint64_t >(file.tellg());
+	if (offset >= fileSize) {
+		return 0;
+	}
+
+	std::vector< std::byte > content(
+		static_cast< std::size_t >((std::min)(static_cast< std::uint64_t >(length), fileSize - offset)));
+	file.seekg(static_cast< std::streamoff >(offset));
+	file.read(reinterpret_cast< char * >(content.data()), static_cast< std::streamsize >(content.size()));
+
+	write(content.data(), content.size(), timeout);
+
+	return content.size();
+}
+
+std::size_t PipeWriter::write_many(const ConstBuffer *messages, std::size_t messageCount,
+								  std::chrono::milliseconds timeout) {
+	assert(messages || messageCount == 0);
+
+	return NamedPipe::write_many(m_pipePath, messages, messageCount, timeout);
+}
+
+bool PipeWriter::try_connect(std::chrono::milliseconds timeout) noexcept {
+	std::filesystem::path pipePath = m_pipePath;
+	if (pipePath.parent_path().empty()) {
+		pipePath = std::filesystem::path("\\\\.\\pipe") / pipePath;
+	}
+
+	// A timeout of 0 would be the special value NMPWAIT_USE_DEFAULT_WAIT
+	const DWORD waitTime = static_cast< DWORD >(
+		(std::min)(std::chrono::milliseconds::rep((std::numeric_limits< DWORD >::max)() - 1), timeout.count()) + 1);
+
+	return WaitNamedPipe(pipePath.string().c_str(), waitTime);
+}
+
+void PipeWriter::disconnect() noexcept {
+}
+
+bool PipeWriter::isConnected() const noexcept {
+	return false;
+}
+#endif // PIPE_PLATFORM_WINDOWS
+
+} // namespace npipe
@@ -0,0 +1,560 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// source tree or at
+// <https://github.com/Krzmbrzl/NamedPipe/blob/main/LICENSE>.
+
+#include "PosixUtils.hpp"
+#include "npipe/InterruptException.hpp"
+#include "npipe/PipeException.hpp"
+#include "npipe/TimeoutException.hpp"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#	include <sys/eventfd.h>
+#	include <sys/inotify.h>
+#endif
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <new>
+#include <optional>
+#include <thread>
+
+namespace npipe {
+
+constexpr std::chrono::milliseconds PIPE_OPEN_WAIT_INTERVAL(1);
+#ifdef IOV_MAX
+constexpr std::size_t MAX_IO_VECTORS = IOV_MAX;
+#else
+constexpr std::size_t MAX_IO_VECTORS = 16;
+#endif
+constexpr std::size_t FILE_COPY_CHUNK_SIZE = 16 * 1024;
+constexpr std::size_t MAX_FILE_CHUNK_SIZE  = 1024 * 1024 * 1024;
+/**
+ * The limit Linux applies to unprivileged pipe resizes unless configured otherwise
+ */
+constexpr std::size_t DEFAULT_MAX_PIPE_CAPACITY = 1024 * 1024;
+
+#ifdef __linux__
+/**
+ * Watches a directory for a specific entry being created, moved in or opened
+ */
+class EntryWatch {
+public:
+	explicit EntryWatch(const std::filesystem::path &path) : m_name(path.filename()) {
+		m_handle = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+		if (m_handle == -1) {
+			return;
+		}
+
+		const std::filesystem::path directory = path.has_parent_path() ? path.parent_path() : ".";
+
+		if (::inotify_add_watch(m_handle, directory.c_str(), IN_CREATE | IN_MOVED_TO | IN_OPEN) == -1) {
+			::close(m_handle);
+			m_handle = -1;
+		}
+	}
+
+	~EntryWatch() {
+		if (m_handle != -1) {
+			::close(m_handle);
+		}
+	}
+
+	EntryWatch(const EntryWatch &) = delete;
+	EntryWatch &operator=(const EntryWatch &) = delete;
+
+	explicit operator bool() const noexcept { return m_handle != -1; }
+
+	/**
+	 * Blocks until there has been an event concerning the watched entry
+	 *
+	 * @param deadline The point in time at which to give up
+	 * @returns Whether there has been an event before the deadline
+	 */
+	bool wait(const Deadline &deadline) noexcept {
+		alignas(inotify_event) std::array< char, 4096 > buffer;
+
+		while (true) {
+			if (waitFor(m_handle, POLLIN, deadline, {}) != Status::Ok) {
+				return false;
+			}
+
+			const ssize_t length = ::read(m_handle, buffer.data(), buffer.size());
+
+			if (length < 0) {
+				if (errno == EAGAIN || errno == EINTR) {
+					continue;
+				}
+
+				// Let the caller check for itself
+				return true;
+			}
+
+			for (std::size_t offset = 0; offset < static_cast< std::size_t >(length);) {
+				const inotify_event *event = reinterpret_cast< const inotify_event * >(buffer.data() + offset);
+
+				// Lost events might have concerned our entry as well
+				if ((event->mask & IN_Q_OVERFLOW) || (event->len > 0 && m_name == event->name)) {
+					return true;
+				}
+
+				offset += sizeof(inotify_event) + event->len;
+			}
+		}
+	}
+
+private:
+	int m_handle = -1;
+	std::filesystem::path m_name;
+};
+#endif
+
+int openForWriting(const std::filesystem::path &pipePath, const Deadline &deadline) noexcept {
+	int handle = ::open(pipePath.c_str(), O_WRONLY | O_NONBLOCK);
+
+	if (handle != -1 || deadline.expired()) {
+		return handle;
+	}
+
+	// Either the pipe doesn't exist yet or there is no reader attached to it (ENXIO). In both cases we wait for the
+	// situation to change.
+#ifdef __linux__
+	std::optional< EntryWatch > watch;
+	try {
+		watch.emplace(pipePath);
+	} catch (const std::bad_alloc &) {
+		// Fall back to polling
+	}
+
+	if (watch && *watch) {
+		while (true) {
+			// The pipe might have become available before the watch has been set up
+			handle = ::open(pipePath.c_str(), O_WRONLY | O_NONBLOCK);
+
+			if (handle != -1 || deadline.expired()) {
+				return handle;
+			}
+
+			if (errno == ENOENT) {
+				// NamedPipe::create only publishes pipes that have a reader already, so the pipe showing up in its
+				// directory tells us when to try again
+				watch->wait(deadline);
+			} else {
+				// A reader opening the pipe in non-blocking mode is reported right away. One using a blocking open()
+				// is only reported once a writer has connected, though, so we have to keep trying.
+				watch->wait(Deadline((std::min)(PIPE_OPEN_WAIT_INTERVAL, deadline.remaining())));
+			}
+		}
+	}
+#endif
+
+	// Without a way of getting notified, we have to resort to polling
+	while (true) {
+		std::this_thread::sleep_for((std::min)(PIPE_OPEN_WAIT_INTERVAL, deadline.remaining()));
+
+		handle = ::open(pipePath.c_str(), O_WRONLY | O_NONBLOCK);
+
+		if (handle != -1 || deadline.expired()) {
+			return handle;
+		}
+	}
+}
+
+Status waitFor(int handle, short events, const Deadline &deadline,
+			   std::initializer_list< int > interruptHandles) noexcept {
+	std::array< pollfd, 4 > pollData;
+	assert(interruptHandles.size() < pollData.size());
+
+	pollData[0]             = { handle, events, 0 };
+	const nfds_t handleCount = static_cast< nfds_t >(interruptHandles.size() + 1);
+	std::transform(interruptHandles.begin(), interruptHandles.end(), pollData.begin() + 1,
+				   [](int interruptHandle) { return pollfd{ interruptHandle, POLLIN, 0 }; });
+
+	while (true) {
+		const int result = ::poll(pollData.data(), handleCount, deadline.pollTimeout());
+
+		if (result < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+
+			return Status::Error;
+		}
+
+		if (std::any_of(pollData.begin() + 1, pollData.begin() + handleCount,
+						[](const pollfd &current) { return current.revents & POLLIN; })) {
+			return Status::Interrupted;
+		}
+
+		if (pollData[0].revents & (events | POLLERR | POLLHUP)) {
+			return Status::Ok;
+		}
+
+		if (pollData[0].revents & POLLNVAL) {
+			errno = EBADF;
+			return Status::Error;
+		}
+
+		if (deadline.expired()) {
+			return Status::Timeout;
+		}
+	}
+}
+
+void throwOnFailure(Status status, int errorCode, const char *context) {
+	switch (status) {
+		case Status::Ok:
+			return;
+		case Status::Timeout:
+			throw TimeoutException();
+		case Status::Interrupted:
+			throw InterruptException();
+		case Status::Closed:
+		case Status::Error:
+			throw PipeException< int >(errorCode, context);
+	}
+}
+
+/**
+ * Transfers the given buffers into a non-blocking pipe handle using the given transfer function, waiting for room
+ * whenever the pipe is full.
+ *
+ * @param transfer A function with the signature of writev that performs the actual transfer
+ * @see writeAll
+ */
+template< typename transfer_t >
+static Status transferAll(int handle, iovec *buffers, std::size_t bufferCount, const Deadline &deadline,
+						  std::size_t &written, transfer_t &&transfer) noexcept {
+	while (true) {
+		// Skip buffers that have been written completely
+		while (bufferCount > 0 && buffers->iov_len == 0) {
+			++buffers;
+			--bufferCount;
+		}
+
+		if (bufferCount == 0) {
+			return Status::Ok;
+		}
+
+		const ssize_t result = transfer(handle, buffers, (std::min)(bufferCount, MAX_IO_VECTORS));
+
+		if (result < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+
+			if (errno != EAGAIN && errno != EWOULDBLOCK) {
+				return Status::Error;
+			}
+
+			// The pipe is full -> wait for the reader to make room
+			const Status waitResult = waitFor(handle, POLLOUT, deadline, {});
+			if (waitResult != Status::Ok) {
+				return waitResult;
+			}
+
+			continue;
+		}
+
+		written += static_cast< std::size_t >(result);
+
+		// Advance the buffers past the written data
+		std::size_t remaining = static_cast< std::size_t >(result);
+		for (std::size_t i = 0; i < bufferCount && remaining > 0; ++i) {
+			const std::size_t consumed = (std::min)(remaining, buffers[i].iov_len);
+
+			buffers[i].iov_base = static_cast< char * >(buffers[i].iov_base) + consumed;
+			buffers[i].iov_len -= consumed;
+			remaining -= consumed;
+		}
+	}
+}
+
+static ssize_t writeVectors(int handle, const iovec *buffers, std::size_t bufferCount) noexcept {
+	return ::writev(handle, buffers, static_cast< int >(bufferCount));
+}
+
+Status writeAll(int handle, iovec *buffers, std::size_t bufferCount, const Deadline &deadline,
+				std::size_t &written) noexcept {
+	return transferAll(handle, buffers, bufferCount, deadline, written, writeVectors);
+}
+
+#ifdef __linux__
+Status spliceAll(int handle, iovec *buffers, std::size_t bufferCount, const Deadline &deadline, std::size_t &written,
+				 bool gift) noexcept {
+	bool spliceSupported = true;
+
+	return transferAll(handle, buffers, bufferCount, deadline, written,
+					   [&](int fd, const iovec *pending, std::size_t pendingCount) {
+						   if (spliceSupported) {
+							   const ssize_t result =
+								   ::vmsplice(fd, pending, pendingCount, SPLICE_F_NONBLOCK | (gift ? SPLICE_F_GIFT : 0));
+
+							   if (result >= 0 || (errno != EINVAL && errno != ENOSYS)) {
+								   return result;
+							   }
+
+							   // The handle doesn't support splicing -> copy the remainder instead
+							   spliceSupported = false;
+						   }
+
+						   return writeVectors(fd, pending, pendingCount);
+					   });
+}
+#endif
+
+Status writeFileRange(int handle, int fileHandle, std::uint64_t offset, std::size_t length, const Deadline &deadline,
+					  std::size_t &written) noexcept {
+#ifdef __linux__
+	bool spliceSupported = true;
+#endif
+	std::array< std::byte, FILE_COPY_CHUNK_SIZE > buffer;
+
+	while (written < length) {
+		const std::size_t chunkSize = (std::min)(length - written, MAX_FILE_CHUNK_SIZE);
+		const off_t position        = static_cast< off_t >(offset + written);
+
+		ssize_t result;
+#ifdef __linux__
+		if (spliceSupported) {
+			loff_t filePosition = position;
+			result = ::splice(fileHandle, &filePosition, handle, nullptr, chunkSize, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+
+			if (result < 0 && (errno == EINVAL || errno == ENOSYS)) {
+				// The file doesn't support splicing -> copy its content instead
+				spliceSupported = false;
+				continue;
+			}
+		} else
+#endif
+		{
+			const ssize_t readBytes = ::pread(fileHandle, buffer.data(), (std::min)(chunkSize, buffer.size()), position);
+
+			if (readBytes < 0) {
+				if (errno == EINTR) {
+					continue;
+				}
+
+				return Status::Error;
+			}
+
+			// If only part of the chunk makes it into the pipe, the remainder is read again in the next iteration
+			result = readBytes > 0 ? ::write(handle, buffer.data(), static_cast< std::size_t >(readBytes)) : 0;
+		}
+
+		if (result < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+
+			if (errno != EAGAIN && errno != EWOULDBLOCK) {
+				return Status::Error;
+			}
+
+			// The pipe is full -> wait for the reader to make room
+			const Status waitResult = waitFor(handle, POLLOUT, deadline, {});
+			if (waitResult != Status::Ok) {
+				return waitResult;
+			}
+
+			continue;
+		}
+
+		if (result == 0) {
+			// Reached the end of the file
+			return Status::Ok;
+		}
+
+		written += static_cast< std::size_t >(result);
+	}
+
+	return Status::Ok;
+}
+
+std::optional< std::size_t > availableBytes(int handle) noexcept {
+	int available = 0;
+	if (::ioctl(handle, FIONREAD, &available) != 0 || available < 0) {
+		return {};
+	}
+
+	return static_cast< std::size_t >(available);
+}
+
+std::optional< std::size_t > pipeCapacity(int handle) noexcept {
+#ifdef F_GETPIPE_SZ
+	const int capacity = ::fcntl(handle, F_GETPIPE_SZ);
+	if (capacity < 0) {
+		return {};
+	}
+
+	return static_cast< std::size_t >(capacity);
+#else
+	(void) handle;
+	errno = ENOTSUP;
+	return {};
+#endif
+}
+
+std::optional< std::size_t > resizePipe(int handle, std::size_t capacity) noexcept {
+#ifdef F_SETPIPE_SZ
+	if (capacity > static_cast< std::size_t >((std::numeric_limits< int >::max)())) {
+		errno = EINVAL;
+		return {};
+	}
+
+	const int resulting = ::fcntl(handle, F_SETPIPE_SZ, static_cast< int >(capacity));
+	if (resulting < 0) {
+		return {};
+	}
+
+	return static_cast< std::size_t >(resulting);
+#else
+	(void) handle;
+	(void) capacity;
+	errno = ENOTSUP;
+	return {};
+#endif
+}
+
+std::size_t maxPipeCapacity() noexcept {
+	static const std::size_t maxCapacity = []() {
+		std::size_t limit = DEFAULT_MAX_PIPE_CAPACITY;
+
+		std::ifstream stream("/proc/sys/fs/pipe-max-size");
+		stream >> limit;
+
+		return stream ? limit : DEFAULT_MAX_PIPE_CAPACITY;
+	}();
+
+	return maxCapacity;
+}
+
+WakeupEvent::WakeupEvent() {
+#ifdef __linux__
+	m_readHandle = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (m_readHandle == -1) {
+		throw PipeException< int >(errno, "Create wakeup event");
+	}
+
+	m_writeHandle = m_readHandle;
+#else
+	std::array< int, 2 > handles;
+	if (::pipe(handles.data()) != 0) {
+		throw PipeException< int >(errno, "Create wakeup event");
+	}
+
+	for (int current : handles) {
+		::fcntl(current, F_SETFL, ::fcntl(current, F_GETFL) | O_NONBLOCK);
+		::fcntl(current, F_SETFD, FD_CLOEXEC);
+	}
+
+	m_readHandle  = handles[0];
+	m_writeHandle = handles[1];
+#endif
+}
+
+WakeupEvent::~WakeupEvent() {
+	if (m_writeHandle != m_readHandle && ::close(m_writeHandle) != 0) {
+		std::cerr << "Failed at closing wakeup event" << std::endl;
+	}
+	if (::close(m_readHandle) != 0) {
+		std::cerr << "Failed at closing wakeup event" << std::endl;
+	}
+}
+
+void WakeupEvent::signal() noexcept {
+#ifdef __linux__
+	const std::uint64_t value = 1;
+#else
+	const char value = 1;
+#endif
+	// If this fails, the event is either signaled already (counter/pipe full) or gone. Either way there is
+	// nothing left to do.
+	[[maybe_unused]] ssize_t written = ::write(m_writeHandle, &value, sizeof(value));
+}
+
+void WakeupEvent::clear() noexcept {
+	std::array< std::uint64_t, 8 > buffer;
+
+	while (::read(m_readHandle, buffer.data(), sizeof(buffer)) > 0) {
+	}
+}
+
+int WakeupEvent::handle() const noexcept {
+	return m_readHandle;
+}
+
+/**
+ * The amount of writes of the current thread that have failed with EPIPE
+ */
+static thread_local unsigned int brokenPipeCount = 0;
+
+void noteBrokenPipe() noexcept {
+	++brokenPipeCount;
+}
+
+/**
+ * @returns Whether the process ignores SIGPIPE, in which case there is no need to block it
+ */
+static bool sigPipeIgnored() noexcept {
+	static const bool ignored = []() {
+		struct sigaction action;
+		return sigaction(SIGPIPE, nullptr, &action) == 0 && action.sa_handler == SIG_IGN;
+	}();
+
+	return ignored;
+}
+
+SigPipeGuard::SigPipeGuard() noexcept
+	: m_brokenPipes(brokenPipeCount), m_uncaughtExceptions(std::uncaught_exceptions()) {
+	if (sigPipeIgnored()) {
+		return;
+	}
+
+	sigset_t sigPipeSet;
+	sigemptyset(&sigPipeSet);
+	sigaddset(&sigPipeSet, SIGPIPE);
+
+	m_blocked = pthread_sigmask(SIG_BLOCK, &sigPipeSet, &m_previousMask) == 0
+				&& sigismember(&m_previousMask, SIGPIPE) != 1;
+}
+
+SigPipeGuard::~SigPipeGuard() {
+	if (!m_blocked) {
+		return;
+	}
+
+	if (brokenPipeCount != m_brokenPipes || std::uncaught_exceptions() > m_uncaughtExceptions) {
+		// Consume the SIGPIPE that has been raised by our own writes (if any) so that it won't be delivered once the
+		// signal gets unblocked again
+		sigset_t sigPipeSet;
+		sigemptyset(&sigPipeSet);
+		sigaddset(&sigPipeSet, SIGPIPE);
+
+		sigset_t pending;
+		sigemptyset(&pending);
+		if (sigpending(&pending) == 0 && sigismember(&pending, SIGPIPE) == 1) {
+			int signal;
+			sigwait(&sigPipeSet, &signal);
+		}
+	}
+
+	pthread_sigmask(SIG_SETMASK, &m_previousMask, nullptr);
+}
+
+} // namespace npipe
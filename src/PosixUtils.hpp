@@ -0,0 +1,225 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// source tree or at
+// <https://github.com/Krzmbrzl/NamedPipe/blob/main/LICENSE>.
+
+#pragma once
+
+#include "npipe/Result.hpp"
+
+#include "Deadline.hpp"
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <initializer_list>
+#include <optional>
+
+#include <signal.h>
+#include <sys/uio.h>
+
+namespace npipe {
+
+/**
+ * Opens the pipe at the given location for writing. As long as the pipe does not exist or has no reading end
+ * attached to it, this function will wait until the given deadline has passed. On Linux, the pipe's directory is
+ * watched via inotify, so the pipe is connected to as soon as it becomes available. Elsewhere, opening is retried
+ * periodically.
+ *
+ * @param pipePath The path to the pipe
+ * @param deadline The point in time at which to give up
+ * @returns The file descriptor of the opened pipe (in non-blocking mode) or -1 if the pipe couldn't be opened before
+ * the deadline
+ */
+int openForWriting(const std::filesystem::path &pipePath, const Deadline &deadline) noexcept;
+
+/**
+ * Turns the given status into the corresponding exception (if it doesn't indicate success)
+ *
+ * @param status The status to check
+ * @param errorCode The error code associated with the status
+ * @param context The context to report in case the status indicates an error
+ */
+void throwOnFailure(Status status, int errorCode, const char *context);
+
+/**
+ * Turns the given status into the corresponding exception (if it doesn't indicate success). The error code is
+ * taken from errno.
+ *
+ * @param status The status to check
+ * @param context The context to report in case the status indicates an error
+ */
+inline void throwOnFailure(Status status, const char *context) {
+	throwOnFailure(status, errno, context);
+}
+
+/**
+ * @param result The result to check
+ * @param context The context to report in case the result indicates an error
+ * @returns The value carried by the given result, if it indicates success. Otherwise the corresponding exception is
+ * thrown.
+ */
+template< typename value_t > value_t unwrap(const Result< value_t > &result, const char *context) {
+	throwOnFailure(result.status(), result.errorCode(), context);
+
+	return result.value();
+}
+
+/**
+ * Waits until the given file descriptor is ready for the given events, the deadline has passed or one of the
+ * provided interrupt descriptors becomes readable - whichever happens first. No CPU time is used while waiting.
+ *
+ * @param handle The file descriptor to wait on
+ * @param events The poll events to wait for (e.g. POLLIN)
+ * @param deadline The point in time at which to give up
+ * @param interruptHandles File descriptors that become readable once the wait shall be interrupted. Negative
+ * values are ignored.
+ * @returns Status::Ok if the descriptor is ready, Status::Timeout, Status::Interrupted or Status::Error (in which
+ * case errno holds the cause)
+ */
+Status waitFor(int handle, short events, const Deadline &deadline,
+			   std::initializer_list< int > interruptHandles) noexcept;
+
+/**
+ * Writes the given buffers to a non-blocking pipe handle. Whenever the pipe is full, this waits for it to have room
+ * again instead of giving up, until the deadline has passed.
+ *
+ * @param handle The file descriptor to write to
+ * @param buffers The buffers to write. These are adjusted in place to describe the part that is still to be written.
+ * @param bufferCount The amount of buffers
+ * @param deadline The point in time at which to give up
+ * @param[in,out] written Incremented by the amount of bytes that have been written
+ * @returns Status::Ok once everything has been written, Status::Timeout if the deadline passed before
+ * that and Status::Error if an error occurred (errno holds the cause)
+ */
+Status writeAll(int handle, iovec *buffers, std::size_t bufferCount, const Deadline &deadline,
+				std::size_t &written) noexcept;
+
+#ifdef __linux__
+/**
+ * Like writeAll, but maps the buffers' pages into the pipe via vmsplice instead of copying their content. If the
+ * handle doesn't support splicing, this falls back to copying.
+ *
+ * @param handle The pipe to write to
+ * @param buffers The buffers to write. These are adjusted in place to describe the part that is still to be written.
+ * @param bufferCount The amount of buffers
+ * @param deadline The point in time at which to give up
+ * @param[in,out] written Incremented by the amount of bytes that have been written
+ * @param gift Whether ownership of the (page-aligned) buffers is transferred to the kernel (SPLICE_F_GIFT)
+ * @returns See writeAll
+ *
+ * @note The buffers must not be modified until the reader has consumed them
+ */
+Status spliceAll(int handle, iovec *buffers, std::size_t bufferCount, const Deadline &deadline, std::size_t &written,
+				 bool gift) noexcept;
+#endif
+
+/**
+ * Writes a range of the given file to a non-blocking pipe handle. On Linux, the content is moved via splice() and
+ * thus never copied through user space. Whenever the pipe is full, this waits for it to have room again until the
+ * deadline has passed.
+ *
+ * @param handle The pipe to write to
+ * @param fileHandle The file to read from. Its file offset is not changed.
+ * @param offset The position in the file to start at
+ * @param length The maximum amount of bytes to write. Writing stops early at the end of the file.
+ * @param deadline The point in time at which to give up
+ * @param[in,out] written The amount of bytes of the range that have been written already. Writing resumes after
+ * those and the value is incremented by the amount of bytes written by this call.
+ * @returns See writeAll
+ */
+Status writeFileRange(int handle, int fileHandle, std::uint64_t offset, std::size_t length, const Deadline &deadline,
+					  std::size_t &written) noexcept;
+
+/**
+ * @returns The amount of bytes that can currently be read from the given pipe handle without blocking or an empty
+ * optional if that can't be determined
+ */
+std::optional< std::size_t > availableBytes(int handle) noexcept;
+
+/**
+ * @returns The size of the kernel buffer of the pipe the given handle refers to or an empty optional if that can't be
+ * determined
+ */
+std::optional< std::size_t > pipeCapacity(int handle) noexcept;
+
+/**
+ * Changes the size of the kernel buffer of the pipe the given handle refers to. The system rounds the requested
+ * capacity up to a power of two pages.
+ *
+ * @returns The resulting capacity or an empty optional if the pipe couldn't be resized (errno is set accordingly,
+ * ENOTSUP on systems without support for resizing pipes)
+ */
+std::optional< std::size_t > resizePipe(int handle, std::size_t capacity) noexcept;
+
+/**
+ * @returns The maximum capacity an unprivileged process may assign to a pipe
+ */
+std::size_t maxPipeCapacity() noexcept;
+
+/**
+ * An event that can be waited on via poll(). Once signaled, its handle stays readable.
+ * This is an eventfd on Linux and a self-pipe on other Posix systems.
+ */
+class WakeupEvent {
+public:
+	WakeupEvent();
+	~WakeupEvent();
+
+	WakeupEvent(const WakeupEvent &) = delete;
+	WakeupEvent &operator=(const WakeupEvent &) = delete;
+
+	/**
+	 * Signals the event, waking up everyone that is waiting on it
+	 */
+	void signal() noexcept;
+
+	/**
+	 * Resets the event to its non-signaled state
+	 */
+	void clear() noexcept;
+
+	/**
+	 * @returns The file descriptor that becomes readable once the event has been signaled
+	 */
+	[[nodiscard]] int handle() const noexcept;
+
+private:
+	int m_readHandle  = -1;
+	int m_writeHandle = -1;
+};
+
+/**
+ * RAII guard that blocks SIGPIPE for the current thread while it is alive. Writing to a pipe without a reader
+ * will then only produce EPIPE instead of killing the process. Writes failing with EPIPE have to be reported via
+ * noteBrokenPipe(), so that the SIGPIPE raised along with them is discarded before the previous signal mask is
+ * restored. The same happens if the guarded scope is left via an exception.
+ *
+ * If the process ignores SIGPIPE (which is checked once, as this is typically set up at startup), the guard doesn't
+ * do anything at all. If the thread blocks SIGPIPE already, pending signals are left to whoever blocked it.
+ */
+class SigPipeGuard {
+public:
+	SigPipeGuard() noexcept;
+	~SigPipeGuard();
+
+	SigPipeGuard(const SigPipeGuard &) = delete;
+	SigPipeGuard &operator=(const SigPipeGuard &) = delete;
+
+private:
+	sigset_t m_previousMask;
+	/**
+	 * The amount of broken pipes the current thread had run into when the guard was created
+	 */
+	unsigned int m_brokenPipes;
+	int m_uncaughtExceptions;
+	bool m_blocked = false;
+};
+
+/**
+ * Records that a write of the current thread has failed with EPIPE (see SigPipeGuard)
+ */
+void noteBrokenPipe() noexcept;
+
+} // namespace npipe
@@ -0,0 +1,463 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// source tree or at
+// <https://github.com/Krzmbrzl/NamedPipe/blob/main/LICENSE>.
+
+#include "npipe/Reactor.hpp"
+#include "npipe/PipeException.hpp"
+
+#include "Deadline.hpp"
+#include "PosixUtils.hpp"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#	include <sys/epoll.h>
+#endif
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+
+namespace npipe {
+
+/**
+ * Tags identify what an event has been reported for. Plain tags are the handle of a registered pipe (or of the wakeup
+ * event), tags with WATCH_TAG set refer to the watch with the ID in the lower bits.
+ */
+constexpr std::uint64_t WATCH_TAG = std::uint64_t(1) << 63;
+/**
+ * Set in addition to WATCH_TAG if the event has been reported for the stop token of the watch
+ */
+constexpr std::uint64_t STOP_TAG = std::uint64_t(1) << 62;
+
+#ifdef __linux__
+/**
+ * The maximum amount of ready pipes that are fetched from the kernel at once
+ */
+constexpr std::size_t MAX_REACTOR_EVENTS = 64;
+
+/**
+ * Adds the given handle to the given epoll instance
+ */
+static bool registerHandle(int pollHandle, int handle, short events, std::uint64_t tag) {
+	epoll_event event = {};
+	event.events      = ((events & POLLIN) ? EPOLLIN : 0u) | ((events & POLLOUT) ? EPOLLOUT : 0u);
+	event.data.u64    = tag;
+
+	return ::epoll_ctl(pollHandle, EPOLL_CTL_ADD, handle, &event) == 0;
+}
+#endif
+
+/**
+ * Removes the given handles from the given epoll instance (if any). As the handles are duplicates, closing them
+ * wouldn't be enough - the registration only goes away once all handles of the underlying file are closed.
+ */
+static void unregisterHandles(int pollHandle, std::initializer_list< int > handles) {
+#ifdef __linux__
+	for (int handle : handles) {
+		if (handle != -1) {
+			::epoll_ctl(pollHandle, EPOLL_CTL_DEL, handle, nullptr);
+		}
+	}
+#else
+	(void) pollHandle;
+	(void) handles;
+#endif
+}
+
+struct Reactor::Watch {
+	/**
+	 * Private duplicate of the watched handle (-1 if only the timeout is waited for). Waiting on a duplicate allows
+	 * the same handle to be watched multiple times (and to be registered as a pipe at the same time).
+	 */
+	int handle = -1;
+	/**
+	 * Private duplicate of the stop token's handle (-1 if the watch can't be cancelled)
+	 */
+	int stopHandle = -1;
+	short events   = 0;
+	completion_t completion;
+	/**
+	 * The entry in m_timers (if the watch has a timeout)
+	 */
+	std::multimap< clock::time_point, std::uint64_t >::iterator timer;
+	bool hasTimer = false;
+
+	~Watch() {
+		for (int current : { handle, stopHandle }) {
+			if (current != -1) {
+				::close(current);
+			}
+		}
+	}
+};
+
+Reactor::Reactor() : m_wakeup(std::make_unique< WakeupEvent >()) {
+#ifdef __linux__
+	m_pollHandle = ::epoll_create1(EPOLL_CLOEXEC);
+	if (m_pollHandle == -1) {
+		throw PipeException< int >(errno, "Create epoll instance");
+	}
+
+	if (!registerHandle(m_pollHandle, m_wakeup->handle(), POLLIN, static_cast< std::uint64_t >(m_wakeup->handle()))) {
+		const int error = errno;
+		::close(m_pollHandle);
+
+		throw PipeException< int >(error, "Register wakeup event");
+	}
+#endif
+}
+
+Reactor::~Reactor() {
+	stop();
+
+	// Wait for an ongoing dispatch to finish
+	std::lock_guard< std::mutex > dispatchGuard(m_dispatchMutex);
+
+	m_watches.clear();
+
+	if (m_pollHandle != -1) {
+		::close(m_pollHandle);
+	}
+}
+
+void Reactor::add(const NamedPipe &pipe, callback_t callback) {
+	const int handle = pipe.m_readHandle;
+
+	if (handle == -1) {
+		throw PipeException< int >(EBADF, "Register pipe");
+	}
+
+	std::lock_guard< std::mutex > guard(m_mutex);
+
+	if (m_entries.find(handle) != m_entries.end()) {
+		throw PipeException< int >(EEXIST, "Register pipe");
+	}
+
+#ifdef __linux__
+	// Level-triggered, so that content a callback leaves in the pipe is reported again
+	if (!registerHandle(m_pollHandle, handle, POLLIN, static_cast< std::uint64_t >(handle))) {
+		throw PipeException< int >(errno, "Register pipe");
+	}
+#else
+	// Make an ongoing wait pick up the new pipe
+	m_wakeup->signal();
+#endif
+
+	m_entries[handle] = std::make_shared< Entry >(&pipe, std::move(callback));
+}
+
+void Reactor::remove(const NamedPipe &pipe) {
+	{
+		std::lock_guard< std::mutex > guard(m_mutex);
+
+		auto it = m_entries.find(pipe.m_readHandle);
+		if (it == m_entries.end() || it->second->pipe != &pipe) {
+			return;
+		}
+
+		// Keeps an ongoing dispatch from invoking the callback
+		it->second->removed.store(true);
+
+#ifdef __linux__
+		::epoll_ctl(m_pollHandle, EPOLL_CTL_DEL, it->first, nullptr);
+#endif
+
+		m_entries.erase(it);
+	}
+
+	if (m_dispatchThread.load() != std::this_thread::get_id()) {
+		// Wait for the callback to finish in case it is running right now
+		std::lock_guard< std::mutex > dispatchGuard(m_dispatchMutex);
+	}
+}
+
+void Reactor::watch(int handle, short events, std::chrono::milliseconds timeout, const StopToken &stopToken,
+					completion_t completion) {
+	std::unique_ptr< Watch > watch = std::make_unique< Watch >();
+	watch->events                  = events;
+	watch->completion              = std::move(completion);
+
+	if (handle != -1) {
+		watch->handle = ::fcntl(handle, F_DUPFD_CLOEXEC, 0);
+		if (watch->handle == -1) {
+			throw PipeException< int >(errno, "Duplicate handle");
+		}
+	}
+
+	if (stopToken.native_handle() != -1) {
+		watch->stopHandle = ::fcntl(stopToken.native_handle(), F_DUPFD_CLOEXEC, 0);
+		if (watch->stopHandle == -1) {
+			throw PipeException< int >(errno, "Duplicate handle");
+		}
+	}
+
+	const Deadline deadline(timeout);
+
+	std::lock_guard< std::mutex > guard(m_mutex);
+
+	const std::uint64_t id = m_nextWatchId++;
+
+#ifdef __linux__
+	if ((watch->handle != -1 && !registerHandle(m_pollHandle, watch->handle, events, WATCH_TAG | id))
+		|| (watch->stopHandle != -1
+			&& !registerHandle(m_pollHandle, watch->stopHandle, POLLIN, WATCH_TAG | STOP_TAG | id))) {
+		const int error = errno;
+		unregisterHandles(m_pollHandle, { watch->handle, watch->stopHandle });
+
+		throw PipeException< int >(error, "Register handle");
+	}
+#endif
+
+	const bool hasTimer = deadline.get() != clock::time_point::max();
+	if (hasTimer) {
+		watch->timer    = m_timers.emplace(deadline.get(), id);
+		watch->hasTimer = true;
+	}
+
+	m_watches.emplace(id, std::move(watch));
+
+#ifdef __linux__
+	if (hasTimer) {
+		// An ongoing wait has to take the new timeout into account
+		m_wakeup->signal();
+	}
+#else
+	m_wakeup->signal();
+#endif
+}
+
+std::size_t Reactor::size() const {
+	std::lock_guard< std::mutex > guard(m_mutex);
+
+	return m_entries.size();
+}
+
+void Reactor::run() {
+	while (!m_stopped.load()) {
+		run_once();
+	}
+}
+
+std::size_t Reactor::run_once(std::chrono::milliseconds timeout) {
+	if (m_stopped.load() || waitForReady(timeout)) {
+		m_ready.clear();
+		m_completions.clear();
+
+		return 0;
+	}
+
+	std::lock_guard< std::mutex > dispatchGuard(m_dispatchMutex);
+	m_dispatchThread.store(std::this_thread::get_id());
+
+	// Completions may start new watches, which may finish right away
+	std::vector< std::pair< completion_t, Status > > completions;
+	completions.swap(m_completions);
+
+	std::size_t invoked   = 0;
+	std::size_t completed = 0;
+
+	try {
+		for (const std::shared_ptr< Entry > &entry : m_ready) {
+			if (entry->removed.load()) {
+				continue;
+			}
+
+			entry->callback(*entry->pipe);
+			++invoked;
+		}
+
+		while (completed < completions.size()) {
+			std::pair< completion_t, Status > &current = completions[completed++];
+			current.first(current.second);
+			++invoked;
+		}
+	} catch (...) {
+		// The watches of the remaining completions are gone already -> only the next run can still invoke them
+		const auto remaining = completions.begin() + static_cast< std::ptrdiff_t >(completed);
+		m_completions.insert(m_completions.begin(), std::make_move_iterator(remaining),
+							 std::make_move_iterator(completions.end()));
+
+		m_dispatchThread.store(std::thread::id());
+		m_ready.clear();
+		throw;
+	}
+
+	m_dispatchThread.store(std::thread::id());
+	m_ready.clear();
+
+	return invoked;
+}
+
+void Reactor::stop() {
+	m_stopped.store(true);
+	m_wakeup->signal();
+}
+
+bool Reactor::stopped() const noexcept {
+	return m_stopped.load();
+}
+
+bool Reactor::waitForReady(std::chrono::milliseconds timeout) {
+	m_ready.clear();
+
+	const Deadline deadline(timeout);
+
+#ifdef __linux__
+	std::array< epoll_event, MAX_REACTOR_EVENTS > events;
+
+	int count = -1;
+	while (count < 0) {
+		int waitFor = -1;
+		{
+			std::lock_guard< std::mutex > guard(m_mutex);
+			waitFor = waitTime(deadline);
+		}
+
+		count = ::epoll_wait(m_pollHandle, events.data(), static_cast< int >(events.size()), waitFor);
+
+		if (count < 0 && errno != EINTR) {
+			throw PipeException< int >(errno, "Wait");
+		}
+	}
+
+	std::lock_guard< std::mutex > guard(m_mutex);
+
+	for (std::size_t i = 0; i < static_cast< std::size_t >(count); ++i) {
+		handleEvent(events[i].data.u64);
+	}
+#else
+	std::vector< pollfd > pollData;
+	std::vector< std::uint64_t > tags;
+
+	int count = -1;
+	while (count < 0) {
+		int waitFor = -1;
+		{
+			std::lock_guard< std::mutex > guard(m_mutex);
+
+			pollData.clear();
+			tags.clear();
+
+			pollData.push_back({ m_wakeup->handle(), POLLIN, 0 });
+			tags.push_back(static_cast< std::uint64_t >(m_wakeup->handle()));
+
+			for (const auto &current : m_entries) {
+				pollData.push_back({ current.first, POLLIN, 0 });
+				tags.push_back(static_cast< std::uint64_t >(current.first));
+			}
+
+			for (const auto &current : m_watches) {
+				if (current.second->handle != -1) {
+					pollData.push_back({ current.second->handle, current.second->events, 0 });
+					tags.push_back(WATCH_TAG | current.first);
+				}
+				if (current.second->stopHandle != -1) {
+					pollData.push_back({ current.second->stopHandle, POLLIN, 0 });
+					tags.push_back(WATCH_TAG | STOP_TAG | current.first);
+				}
+			}
+
+			waitFor = waitTime(deadline);
+		}
+
+		count = ::poll(pollData.data(), static_cast< nfds_t >(pollData.size()), waitFor);
+
+		if (count < 0 && errno != EINTR) {
+			throw PipeException< int >(errno, "Wait");
+		}
+	}
+
+	std::lock_guard< std::mutex > guard(m_mutex);
+
+	for (std::size_t i = 0; i < pollData.size(); ++i) {
+		if (pollData[i].revents & (pollData[i].events | POLLERR | POLLHUP)) {
+			handleEvent(tags[i]);
+		}
+	}
+#endif
+
+	expireWatches();
+
+	return m_stopped.load();
+}
+
+int Reactor::waitTime(const Deadline &deadline) const {
+	if (!m_completions.empty()) {
+		// Left over from a run that has been aborted by an exception
+		return 0;
+	}
+
+	int waitFor = deadline.pollTimeout();
+
+	if (!m_timers.empty()) {
+		const clock::time_point now = clock::now();
+		const std::chrono::milliseconds untilTimer =
+			m_timers.begin()->first > now
+				? std::chrono::ceil< std::chrono::milliseconds >(m_timers.begin()->first - now)
+				: std::chrono::milliseconds(0);
+
+		if (waitFor < 0 || untilTimer.count() < waitFor) {
+			waitFor = static_cast< int >(untilTimer.count());
+		}
+	}
+
+	return waitFor;
+}
+
+void Reactor::handleEvent(std::uint64_t tag) {
+	if (tag & WATCH_TAG) {
+		// Watches that have been finished for a different reason already are not found anymore
+		finishWatch(tag & ~(WATCH_TAG | STOP_TAG), (tag & STOP_TAG) ? Status::Interrupted : Status::Ok);
+		return;
+	}
+
+	const int handle = static_cast< int >(tag);
+
+	if (handle == m_wakeup->handle()) {
+		if (!m_stopped.load()) {
+			// The registrations have changed -> the next wait takes them into account
+			m_wakeup->clear();
+		}
+		return;
+	}
+
+	auto it = m_entries.find(handle);
+
+	// Events of pipes that have been removed in the meantime are skipped
+	if (it != m_entries.end()) {
+		m_ready.push_back(it->second);
+	}
+}
+
+void Reactor::finishWatch(std::uint64_t id, Status status) {
+	auto it = m_watches.find(id);
+	if (it == m_watches.end()) {
+		return;
+	}
+
+	if (it->second->hasTimer) {
+		m_timers.erase(it->second->timer);
+	}
+
+	unregisterHandles(m_pollHandle, { it->second->handle, it->second->stopHandle });
+
+	m_completions.emplace_back(std::move(it->second->completion), status);
+	m_watches.erase(it);
+}
+
+void Reactor::expireWatches() {
+	const clock::time_point now = clock::now();
+
+	while (!m_timers.empty() && m_timers.begin()->first <= now) {
+		finishWatch(m_timers.begin()->second, Status::Timeout);
+	}
+}
+
+} // namespace npipe
@@ -0,0 +1,70 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// source tree or at
+// <https://github.com/Krzmbrzl/NamedPipe/blob/main/LICENSE>.
+
+#include "npipe/StopToken.hpp"
+
+#ifdef PIPE_PLATFORM_UNIX
+#	include "PosixUtils.hpp"
+#endif
+
+#include <atomic>
+#include <utility>
+
+namespace npipe {
+
+struct StopState {
+	std::atomic_bool stopRequested = false;
+
+#ifdef PIPE_PLATFORM_UNIX
+	/**
+	 * Event that is signaled once a stop is requested. This allows to wait on it alongside the pipe itself.
+	 */
+	WakeupEvent event;
+#endif
+};
+
+
+StopSource::StopSource() : m_state(std::make_shared< StopState >()) {
+}
+
+StopToken StopSource::get_token() const noexcept {
+	return StopToken(m_state);
+}
+
+bool StopSource::request_stop() noexcept {
+	if (!m_state || m_state->stopRequested.exchange(true)) {
+		return false;
+	}
+
+#ifdef PIPE_PLATFORM_UNIX
+	m_state->event.signal();
+#endif
+
+	return true;
+}
+
+bool StopSource::stop_requested() const noexcept {
+	return m_state && m_state->stopRequested.load();
+}
+
+
+StopToken::StopToken(std::shared_ptr< StopState > state) noexcept : m_state(std::move(state)) {
+}
+
+bool StopToken::stop_requested() const noexcept {
+	return m_state && m_state->stopRequested.load();
+}
+
+bool StopToken::stop_possible() const noexcept {
+	return m_state != nullptr;
+}
+
+#ifdef PIPE_PLATFORM_UNIX
+int StopToken::native_handle() const noexcept {
+	return m_state ? m_state->event.handle() : -1;
+}
+#endif
+
+} // namespace npipe
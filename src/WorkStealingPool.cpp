@@ -0,0 +1,135 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// source tree or at
+// <https://github.com/Krzmbrzl/NamedPipe/blob/main/LICENSE>.
+
+#include "WorkStealingPool.hpp"
+
+#include <algorithm>
+#include <utility>
+
+namespace npipe {
+
+/**
+ * The pool the current thread is a worker of (if any)
+ */
+static thread_local const WorkStealingPool *currentPool = nullptr;
+/**
+ * The index of the current thread within currentPool
+ */
+static thread_local std::size_t currentWorker = 0;
+
+WorkStealingPool::WorkStealingPool(std::size_t threadCount) {
+	if (threadCount == 0) {
+		threadCount = (std::max)(std::thread::hardware_concurrency(), 1u);
+	}
+
+	m_workers.reserve(threadCount);
+	for (std::size_t i = 0; i < threadCount; ++i) {
+		m_workers.push_back(std::make_unique< Worker >());
+	}
+
+	m_threads.reserve(threadCount);
+	for (std::size_t i = 0; i < threadCount; ++i) {
+		m_threads.emplace_back([this, i]() { runWorker(i); });
+	}
+}
+
+WorkStealingPool::~WorkStealingPool() {
+	stop();
+}
+
+void WorkStealingPool::stop() {
+	{
+		std::lock_guard< std::mutex > guard(m_sleepMutex);
+		m_stop = true;
+	}
+
+	m_wakeup.notify_all();
+
+	for (std::thread &current : m_threads) {
+		if (current.joinable()) {
+			current.join();
+		}
+	}
+}
+
+void WorkStealingPool::submit(task_t task) {
+	// Tasks submitted by a worker are likely related to what it has just been doing
+	const std::size_t index =
+		currentPool == this ? currentWorker : m_nextWorker.fetch_add(1, std::memory_order_relaxed) % m_workers.size();
+
+	// Counting the task before it is queued keeps the counter from ever dropping below zero
+	m_pending.fetch_add(1);
+
+	{
+		std::lock_guard< std::mutex > guard(m_workers[index]->mutex);
+		m_workers[index]->tasks.push_back(std::move(task));
+	}
+
+	if (m_sleeping.load() > 0) {
+		// Taking the lock makes sure that a worker that is about to go to sleep either sees the new task or gets
+		// notified
+		{ std::lock_guard< std::mutex > guard(m_sleepMutex); }
+
+		m_wakeup.notify_one();
+	}
+}
+
+std::size_t WorkStealingPool::size() const noexcept {
+	return m_workers.size();
+}
+
+void WorkStealingPool::runWorker(std::size_t index) {
+	currentPool   = this;
+	currentWorker = index;
+
+	task_t task;
+
+	while (true) {
+		if (take(index, task)) {
+			task();
+			task = nullptr;
+			continue;
+		}
+
+		std::unique_lock< std::mutex > lock(m_sleepMutex);
+
+		m_sleeping.fetch_add(1);
+		m_wakeup.wait(lock, [this]() { return m_stop || m_pending.load() > 0; });
+		m_sleeping.fetch_sub(1);
+
+		if (m_stop && m_pending.load() == 0) {
+			return;
+		}
+	}
+}
+
+bool WorkStealingPool::take(std::size_t index, task_t &task) {
+	for (std::size_t offset = 0; offset < m_workers.size(); ++offset) {
+		Worker &worker = *m_workers[(index + offset) % m_workers.size()];
+
+		std::lock_guard< std::mutex > guard(worker.mutex);
+
+		if (worker.tasks.empty()) {
+			continue;
+		}
+
+		if (offset == 0) {
+			task = std::move(worker.tasks.front());
+			worker.tasks.pop_front();
+		} else {
+			// Steal from the other end, so that the owner and the thief don't keep competing for the same tasks
+			task = std::move(worker.tasks.back());
+			worker.tasks.pop_back();
+		}
+
+		m_pending.fetch_sub(1);
+
+		return true;
+	}
+
+	return false;
+}
+
+} // namespace npipe
@@ -0,0 +1,88 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// source tree or at
+// <https://github.com/Krzmbrzl/NamedPipe/blob/main/LICENSE>.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace npipe {
+
+/**
+ * Thread pool in which every worker has a queue of its own. Tasks submitted from outside the pool are distributed
+ * among the workers round-robin, tasks submitted from within a worker stay with that worker. A worker that runs out
+ * of tasks steals from the other workers' queues, so that a few long-running tasks don't hold up the tasks queued
+ * behind them.
+ */
+class WorkStealingPool {
+public:
+	using task_t = std::function< void() >;
+
+	/**
+	 * @param threadCount The amount of worker threads. 0 means one per hardware thread.
+	 */
+	explicit WorkStealingPool(std::size_t threadCount);
+	/**
+	 * Stops the pool (see stop())
+	 */
+	~WorkStealingPool();
+
+	WorkStealingPool(const WorkStealingPool &) = delete;
+	WorkStealingPool &operator=(const WorkStealingPool &) = delete;
+
+	/**
+	 * Queues the given task for being run by any of the workers. This function is thread-safe.
+	 */
+	void submit(task_t task);
+
+	/**
+	 * Runs all tasks that have been submitted so far (including the ones they submit in turn) and stops the workers.
+	 * The pool stays usable for the tasks while this is ongoing. Calling this function multiple times is allowed.
+	 */
+	void stop();
+
+	/**
+	 * @returns The amount of worker threads
+	 */
+	[[nodiscard]] std::size_t size() const noexcept;
+
+private:
+	struct Worker {
+		std::mutex mutex;
+		/**
+		 * The worker itself takes tasks from the front, thieves take them from the back
+		 */
+		std::deque< task_t > tasks;
+	};
+
+	std::vector< std::unique_ptr< Worker > > m_workers;
+	std::vector< std::thread > m_threads;
+	std::atomic_size_t m_nextWorker = 0;
+	/**
+	 * The amount of tasks that have been submitted but not taken by a worker yet
+	 */
+	std::atomic_size_t m_pending = 0;
+	std::atomic_size_t m_sleeping = 0;
+	bool m_stop                   = false;
+	std::mutex m_sleepMutex;
+	std::condition_variable m_wakeup;
+
+	void runWorker(std::size_t index);
+	/**
+	 * Takes a task from the given worker's own queue or (if that's empty) from another worker's queue
+	 *
+	 * @returns Whether a task has been found
+	 */
+	bool take(std::size_t index, task_t &task);
+};
+
+} // namespace npipe
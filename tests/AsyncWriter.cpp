@@ -0,0 +1,210 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// source tree or at
+// <https://github.com/Krzmbrzl/NamedPipe/blob/main/LICENSE>.
+
+#include "npipe/AsyncWriter.hpp"
+#include "npipe/NamedPipe.hpp"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <filesystem>
+#include <future>
+#include <thread>
+#include <vector>
+
+constexpr const char *asyncPipeName = "asyncWriterTestPipe";
+
+TEST(AsyncWriter, ordered_completions) {
+	npipe::NamedPipe pipe = npipe::NamedPipe::create(asyncPipeName);
+
+	npipe::AsyncWriterOptions options;
+	options.framed = true;
+
+	constexpr std::size_t messageCount = 500;
+	std::atomic_size_t completed       = 0;
+	std::atomic_size_t failed          = 0;
+
+	{
+		npipe::AsyncWriter writer(options);
+
+		for (std::size_t i = 0; i < messageCount; ++i) {
+			const std::vector< std::byte > message = { static_cast< std::byte >(i & 0xFF),
+													   static_cast< std::byte >(i >> 8) };
+
+			const bool queued = writer.write_async(
+				asyncPipeName, message.data(), message.size(),
+				[&](npipe::Result< std::size_t > result) {
+					if (!result || result.value() != 2) {
+						++failed;
+					}
+					++completed;
+				},
+				std::chrono::seconds(5));
+			ASSERT_TRUE(queued);
+		}
+
+		std::size_t received = 0;
+		npipe::MessageBatch batch;
+		while (received < messageCount) {
+			pipe.read_batch(batch, std::chrono::seconds(5));
+
+			for (const npipe::ConstBuffer &message : batch) {
+				ASSERT_EQ(message.size, 2);
+
+				const std::size_t sequence =
+					static_cast< std::size_t >(message.data[0]) | (static_cast< std::size_t >(message.data[1]) << 8);
+				ASSERT_EQ(sequence, received);
+				++received;
+			}
+		}
+	}
+
+	ASSERT_EQ(completed.load(), messageCount);
+	ASSERT_EQ(failed.load(), 0);
+}
+
+TEST(AsyncWriter, future) {
+	npipe::NamedPipe pipe = npipe::NamedPipe::create(asyncPipeName);
+
+	const std::vector< std::byte > message = { std::byte(1), std::byte(2), std::byte(3) };
+
+	std::future< npipe::Result< std::size_t > > future =
+		npipe::NamedPipe::write_async(asyncPipeName, message.data(), message.size(), std::chrono::seconds(1));
+
+	ASSERT_EQ(pipe.read_blocking(std::chrono::seconds(1)), message);
+
+	const npipe::Result< std::size_t > result = future.get();
+	ASSERT_TRUE(result.ok());
+	ASSERT_EQ(result.value(), message.size());
+}
+
+TEST(AsyncWriter, framed_timeout_mid_frame) {
+	npipe::NamedPipe pipe = npipe::NamedPipe::create(asyncPipeName);
+
+	npipe::AsyncWriterOptions options;
+	options.framed = true;
+
+	npipe::AsyncWriter writer(options);
+
+	// Way more than fits into the pipe, so that the timeout expires while the frame is being written
+	const std::vector< std::byte > large(256 * 1024, std::byte(5));
+	const std::vector< std::byte > small(7, std::byte(3));
+
+	std::future< npipe::Result< std::size_t > > first =
+		writer.write_async(asyncPipeName, large.data(), large.size(), std::chrono::milliseconds(50));
+	std::future< npipe::Result< std::size_t > > second =
+		writer.write_async(asyncPipeName, small.data(), small.size(), std::chrono::seconds(5));
+
+	std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+	// The started frame has been finished instead of being followed by the next one
+	ASSERT_EQ(pipe.read_message(std::chrono::seconds(5)), large);
+	ASSERT_EQ(pipe.read_message(std::chrono::seconds(5)), small);
+
+	const npipe::Result< std::size_t > firstResult = first.get();
+	ASSERT_TRUE(firstResult.ok());
+	ASSERT_EQ(firstResult.value(), large.size());
+	ASSERT_TRUE(second.get().ok());
+}
+
+TEST(AsyncWriter, reject_when_full) {
+	npipe::AsyncWriterOptions options;
+	options.capacity = 2;
+
+	npipe::AsyncWriter writer(options);
+
+	const std::vector< std::byte > message = { std::byte(1) };
+
+	// Hold up the background thread in a completion, so that the following writes stay queued
+	std::promise< void > release;
+	std::atomic_bool blocked = false;
+	ASSERT_TRUE(writer.write_async(
+		"nonExistingAsyncPipe", message.data(), message.size(),
+		[&, released = release.get_future().share()](npipe::Result< std::size_t >) {
+			blocked = true;
+			released.wait();
+		},
+		std::chrono::milliseconds(0)));
+
+	while (!blocked) {
+		std::this_thread::yield();
+	}
+
+	std::vector< std::future< npipe::Result< std::size_t > > > futures;
+	for (int i = 0; i < 3; ++i) {
+		futures.push_back(writer.write_async("nonExistingAsyncPipe", message.data(), message.size()));
+	}
+
+	// The last write didn't fit into the queue, so it is rejected without waiting
+	ASSERT_EQ(futures[2].wait_for(std::chrono::seconds(0)), std::future_status::ready);
+	ASSERT_EQ(futures[2].get().status(), npipe::Status::Timeout);
+
+	release.set_value();
+
+	for (std::size_t i = 0; i < 2; ++i) {
+		ASSERT_EQ(futures[i].get().status(), npipe::Status::Closed);
+	}
+}
+
+TEST(AsyncWriter, no_reader_fails_fast) {
+	npipe::AsyncWriter writer;
+
+	const std::vector< std::byte > message = { std::byte(1) };
+
+	const auto start = std::chrono::steady_clock::now();
+
+	std::future< npipe::Result< std::size_t > > missing =
+		writer.write_async("nonExistingAsyncPipe", message.data(), message.size(), std::chrono::seconds(5));
+
+	// A pipe without a reader must not hold up the writes to other pipes for the entire timeout
+	npipe::NamedPipe pipe = npipe::NamedPipe::create(asyncPipeName);
+	std::future< npipe::Result< std::size_t > > existing =
+		writer.write_async(asyncPipeName, message.data(), message.size(), std::chrono::seconds(5));
+
+	ASSERT_EQ(missing.get().status(), npipe::Status::Closed);
+	ASSERT_TRUE(existing.get().ok());
+	ASSERT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(1));
+
+	ASSERT_EQ(pipe.read_blocking(std::chrono::seconds(1)), message);
+}
+
+#ifdef __linux__
+/**
+ * @returns The amount of file descriptors of this process that refer to the given file
+ */
+static std::size_t countOpenHandles(const std::filesystem::path &path) {
+	const std::filesystem::path target = std::filesystem::absolute(path);
+
+	std::size_t count = 0;
+	for (const std::filesystem::directory_entry &entry : std::filesystem::directory_iterator("/proc/self/fd")) {
+		std::error_code error;
+		if (std::filesystem::read_symlink(entry.path(), error) == target) {
+			++count;
+		}
+	}
+
+	return count;
+}
+
+TEST(AsyncWriter, evict_idle_connections) {
+	npipe::NamedPipe pipe = npipe::NamedPipe::create(asyncPipeName);
+	const std::size_t readerHandles = countOpenHandles(asyncPipeName);
+
+	npipe::AsyncWriterOptions options;
+	options.idleTimeout = std::chrono::milliseconds(100);
+
+	npipe::AsyncWriter writer(options);
+
+	const std::vector< std::byte > message = { std::byte(1) };
+	ASSERT_TRUE(writer.write_async(asyncPipeName, message.data(), message.size()).get().ok());
+	ASSERT_EQ(countOpenHandles(asyncPipeName), readerHandles + 1);
+
+	std::this_thread::sleep_for(std::chrono::milliseconds(300));
+
+	ASSERT_EQ(countOpenHandles(asyncPipeName), readerHandles);
+}
+#endif
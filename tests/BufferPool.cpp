@@ -0,0 +1,83 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// source tree or at
+// <https://github.com/Krzmbrzl/NamedPipe/blob/main/LICENSE>.
+
+#include "npipe/BufferPool.hpp"
+#include "npipe/NamedPipe.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <thread>
+#include <utility>
+#include <vector>
+
+constexpr const char *poolPipeName = "poolTestPipe";
+
+TEST(BufferPool, reuse) {
+	npipe::BufferPool pool;
+
+	npipe::Message message = pool.acquire(100);
+	ASSERT_EQ(message.size(), 100);
+	ASSERT_GE(message.capacity(), 100);
+
+	const std::byte *buffer = message.data();
+	message.release();
+	ASSERT_TRUE(message.empty());
+
+	// Same size class -> the buffer has to be reused
+	npipe::Message other = pool.acquire(200);
+	ASSERT_EQ(other.data(), buffer);
+
+	// Moving must transfer ownership instead of returning the buffer to the pool
+	npipe::Message moved = std::move(other);
+	ASSERT_EQ(moved.data(), buffer);
+	ASSERT_NE(pool.acquire(200).data(), buffer);
+}
+
+TEST(BufferPool, resize) {
+	npipe::BufferPool pool;
+
+	npipe::Message message = pool.acquire(3);
+	std::fill(message.begin(), message.end(), std::byte(42));
+
+	message.resize(10 * npipe::BufferPool::minBufferSize);
+
+	ASSERT_GE(message.capacity(), 10 * npipe::BufferPool::minBufferSize);
+	ASSERT_TRUE(std::all_of(message.begin(), message.begin() + 3, [](std::byte b) { return b == std::byte(42); }));
+}
+
+TEST(BufferPool, concurrent_use) {
+	npipe::BufferPool pool(4);
+
+	std::vector< std::thread > threads;
+	for (std::size_t i = 0; i < 4; ++i) {
+		threads.emplace_back([&pool, i]() {
+			for (std::size_t k = 0; k < 10000; ++k) {
+				npipe::Message message = pool.acquire((i + 1) * k % 5000);
+				std::fill(message.begin(), message.end(), std::byte(i));
+
+				ASSERT_TRUE(std::all_of(message.begin(), message.end(), [i](std::byte b) { return b == std::byte(i); }));
+			}
+		});
+	}
+
+	for (std::thread &thread : threads) {
+		thread.join();
+	}
+}
+
+TEST(NamedPipe, pooled_read) {
+	npipe::NamedPipe pipe = npipe::NamedPipe::create(poolPipeName);
+	npipe::BufferPool pool;
+
+	const std::vector< std::byte > content(1000, std::byte(7));
+	npipe::NamedPipe::write(poolPipeName, content.data(), content.size(), std::chrono::seconds(1));
+
+	npipe::Message message = pipe.read_blocking(pool, std::chrono::seconds(1));
+
+	ASSERT_EQ(std::vector< std::byte >(message.begin(), message.end()), content);
+}
@@ -0,0 +1,98 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// source tree or at
+// <https://github.com/Krzmbrzl/NamedPipe/blob/main/LICENSE>.
+
+#include "npipe/NamedPipe.hpp"
+#include "npipe/PipeCapacity.hpp"
+#include "npipe/PipeWriter.hpp"
+#include "npipe/TimeoutException.hpp"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+// Only Linux allows resizing pipes
+#ifdef __linux__
+
+constexpr const char *capacityPipeName = "capacityTestPipe";
+
+TEST(NamedPipe, create_with_capacity) {
+	npipe::NamedPipe pipe = npipe::NamedPipe::create(capacityPipeName, 256 * 1024);
+
+	ASSERT_EQ(pipe.getCapacity(), 256 * 1024);
+
+	ASSERT_EQ(pipe.setCapacity(128 * 1024), 128 * 1024);
+	ASSERT_EQ(pipe.getCapacity(), 128 * 1024);
+}
+
+TEST(PipeWriter, set_capacity) {
+	npipe::NamedPipe pipe = npipe::NamedPipe::create(capacityPipeName);
+	npipe::PipeWriter writer(capacityPipeName);
+
+	ASSERT_EQ(writer.setCapacity(128 * 1024), 128 * 1024);
+	ASSERT_EQ(writer.getCapacity(), 128 * 1024);
+	ASSERT_EQ(pipe.getCapacity(), 128 * 1024);
+}
+
+TEST(NamedPipe, adaptive_capacity) {
+	npipe::NamedPipe pipe = npipe::NamedPipe::create(capacityPipeName, 64 * 1024);
+	npipe::PipeWriter writer(capacityPipeName);
+
+	npipe::AdaptiveCapacityOptions options;
+	options.minCapacity = 64 * 1024;
+	options.growAfter   = 2;
+	options.shrinkAfter = std::chrono::milliseconds(300);
+	pipe.enableAdaptiveCapacity(options);
+
+	const std::vector< std::byte > burst(60 * 1024, std::byte(42));
+
+	// Two reads in a row find the pipe almost full -> its capacity gets doubled
+	for (int i = 0; i < 2; ++i) {
+		writer.write(burst.data(), burst.size());
+		ASSERT_EQ(pipe.read_blocking(std::chrono::milliseconds(100)).size(), burst.size());
+	}
+
+	npipe::CapacityMetrics metrics = pipe.getCapacityMetrics();
+	ASSERT_EQ(metrics.capacity, 128 * 1024);
+	ASSERT_EQ(metrics.growCount, 1);
+	ASSERT_EQ(metrics.peakFillLevel, burst.size());
+	ASSERT_EQ(metrics.fillLevel, 0);
+
+	// A read that finds the pipe (almost) empty lets it shrink back as it has been idle for long enough
+	std::this_thread::sleep_for(options.shrinkAfter);
+	writer.write(burst.data(), 16);
+	ASSERT_EQ(pipe.read_blocking(std::chrono::milliseconds(100)).size(), 16);
+
+	metrics = pipe.getCapacityMetrics();
+	ASSERT_EQ(metrics.capacity, 64 * 1024);
+	ASSERT_EQ(metrics.shrinkCount, 1);
+	ASSERT_EQ(metrics.failedResizeCount, 0);
+}
+
+TEST(NamedPipe, adaptive_capacity_idle) {
+	npipe::NamedPipe pipe = npipe::NamedPipe::create(capacityPipeName, 256 * 1024);
+
+	npipe::AdaptiveCapacityOptions options;
+	options.minCapacity = 64 * 1024;
+	options.shrinkAfter = std::chrono::milliseconds(50);
+	pipe.enableAdaptiveCapacity(options);
+
+	// A reader waiting on a pipe that doesn't see any traffic shrinks it step by step
+	ASSERT_THROW((void) pipe.read_blocking(std::chrono::milliseconds(300)), npipe::TimeoutException);
+	ASSERT_EQ(pipe.getCapacity(), 64 * 1024);
+
+	// Without any reader, monitoring the pipe shrinks it
+	pipe.setCapacity(256 * 1024);
+	pipe.enableAdaptiveCapacity(options);
+	std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+	const npipe::CapacityMetrics metrics = pipe.getCapacityMetrics();
+	ASSERT_EQ(metrics.capacity, 128 * 1024);
+	ASSERT_EQ(metrics.shrinkCount, 1);
+}
+
+#endif
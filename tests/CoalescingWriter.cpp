@@ -0,0 +1,169 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// source tree or at
+// <https://github.com/Krzmbrzl/NamedPipe/blob/main/LICENSE>.
+
+#include "npipe/CoalescingWriter.hpp"
+#include "npipe/Framing.hpp"
+#include "npipe/FramingException.hpp"
+#include "npipe/NamedPipe.hpp"
+#include "npipe/TimeoutException.hpp"
+
+#include <gtest/gtest.h>
+
+#ifdef PIPE_PLATFORM_UNIX
+#	include <time.h>
+#endif
+
+#include <chrono>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+constexpr const char *coalescingPipeName = "coalescingTestPipe";
+
+TEST(CoalescingWriter, concurrent_writers) {
+	npipe::NamedPipe pipe = npipe::NamedPipe::create(coalescingPipeName);
+
+	constexpr std::size_t threadCount       = 4;
+	constexpr std::size_t messagesPerThread = 2000;
+
+	npipe::CoalescingWriter writer(coalescingPipeName);
+
+	std::vector< std::thread > threads;
+	for (std::size_t i = 0; i < threadCount; ++i) {
+		threads.emplace_back([&writer, i]() {
+			for (std::size_t j = 0; j < messagesPerThread; ++j) {
+				// Thread ID followed by a per-thread sequence number
+				const std::vector< std::byte > message = { static_cast< std::byte >(i),
+														   static_cast< std::byte >(j & 0xFF),
+														   static_cast< std::byte >(j >> 8) };
+				writer.write(message.data(), message.size(), std::chrono::seconds(5));
+			}
+		});
+	}
+
+	// Every thread's messages have to arrive completely and in order
+	std::vector< std::size_t > nextSequence(threadCount, 0);
+	npipe::MessageBatch batch;
+	std::size_t received = 0;
+	while (received < threadCount * messagesPerThread) {
+		received += pipe.read_batch(batch, std::chrono::seconds(5));
+
+		for (const npipe::ConstBuffer &message : batch) {
+			ASSERT_EQ(message.size, 3);
+
+			const std::size_t thread   = static_cast< std::size_t >(message.data[0]);
+			const std::size_t sequence = static_cast< std::size_t >(message.data[1])
+										 | (static_cast< std::size_t >(message.data[2]) << 8);
+
+			ASSERT_LT(thread, threadCount);
+			ASSERT_EQ(sequence, nextSequence[thread]);
+			++nextSequence[thread];
+		}
+	}
+
+	for (std::thread &current : threads) {
+		current.join();
+	}
+
+	ASSERT_EQ(received, threadCount * messagesPerThread);
+}
+
+TEST(CoalescingWriter, latency_bound) {
+	npipe::NamedPipe pipe = npipe::NamedPipe::create(coalescingPipeName);
+
+	npipe::CoalescingWriterOptions options;
+	options.maxLatency = std::chrono::milliseconds(20);
+
+	npipe::CoalescingWriter writer(coalescingPipeName, options);
+
+	const std::vector< std::byte > message = { std::byte(1), std::byte(2) };
+	writer.write(message.data(), message.size());
+	writer.write(message.data(), message.size());
+
+	// Way below the flush threshold, so only the latency bound can cause the messages to be written (together)
+	const npipe::MessageBatch batch = pipe.read_batch(std::chrono::seconds(1));
+	ASSERT_EQ(batch.size(), 2);
+
+	writer.write(message.data(), message.size());
+	writer.flush();
+	ASSERT_EQ(pipe.read_batch(std::chrono::milliseconds(0)).size(), 1);
+}
+
+TEST(CoalescingWriter, reject_oversized_frame) {
+	npipe::NamedPipe pipe = npipe::NamedPipe::create(coalescingPipeName);
+
+	npipe::CoalescingWriter writer(coalescingPipeName);
+
+	const std::vector< std::byte > oversized(npipe::FrameHeader::maxLength + 1);
+	ASSERT_THROW(writer.write(oversized.data(), oversized.size()), npipe::FramingException);
+
+	// The buffer isn't stuck on the rejected message
+	const std::vector< std::byte > message = { std::byte(1), std::byte(2) };
+	writer.write(message.data(), message.size());
+	ASSERT_NO_THROW(writer.flush(std::chrono::seconds(1)));
+
+	ASSERT_EQ(pipe.read_message(std::chrono::seconds(1)), message);
+}
+
+TEST(CoalescingWriter, resume_partial_write) {
+	npipe::NamedPipe pipe = npipe::NamedPipe::create(coalescingPipeName);
+
+	npipe::CoalescingWriterOptions options;
+	options.framed       = false;
+	options.writeTimeout = std::chrono::milliseconds(20);
+
+	npipe::CoalescingWriter writer(coalescingPipeName, options);
+
+	// Both messages together are way more than fits into the pipe, so the first attempts time out half-way through
+	std::vector< std::byte > content(2 * 100 * 1024);
+	for (std::size_t i = 0; i < content.size(); ++i) {
+		content[i] = static_cast< std::byte >(i % 251);
+	}
+
+	writer.write(content.data(), content.size() / 2);
+	writer.write(content.data() + content.size() / 2, content.size() / 2);
+
+	std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+	std::vector< std::byte > received(content.size());
+	std::size_t receivedBytes = 0;
+	while (receivedBytes < received.size()) {
+		receivedBytes += pipe.read_into(received.data() + receivedBytes, received.size() - receivedBytes,
+										std::chrono::seconds(5));
+	}
+
+	ASSERT_EQ(received, content);
+
+	// Nothing must have been sent twice
+	std::byte extra;
+	ASSERT_THROW(pipe.read_into(&extra, 1, std::chrono::milliseconds(100)), npipe::TimeoutException);
+}
+
+#ifdef PIPE_PLATFORM_UNIX
+TEST(CoalescingWriter, wait_for_room_without_spinning) {
+	npipe::CoalescingWriterOptions options;
+	options.capacity = 2;
+
+	// Without a pipe, the buffered messages can't be written, so the buffer stays full
+	npipe::CoalescingWriter writer("nonExistingCoalescingPipe", options);
+
+	const std::vector< std::byte > message = { std::byte(1) };
+	writer.write(message.data(), message.size());
+	writer.write(message.data(), message.size());
+
+	timespec before;
+	::clock_gettime(CLOCK_THREAD_CPUTIME_ID, &before);
+
+	ASSERT_THROW(writer.write(message.data(), message.size(), std::chrono::milliseconds(300)),
+				 npipe::TimeoutException);
+
+	timespec after;
+	::clock_gettime(CLOCK_THREAD_CPUTIME_ID, &after);
+
+	const auto cpuTime = std::chrono::seconds(after.tv_sec - before.tv_sec)
+						 + std::chrono::nanoseconds(after.tv_nsec - before.tv_nsec);
+	ASSERT_LT(cpuTime, std::chrono::milliseconds(50));
+}
+#endif
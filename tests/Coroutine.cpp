@@ -0,0 +1,131 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// source tree or at
+// <https://github.com/Krzmbrzl/NamedPipe/blob/main/LICENSE>.
+
+#include "npipe/InterruptException.hpp"
+#include "npipe/NamedPipe.hpp"
+#include "npipe/PipeWriter.hpp"
+#include "npipe/Reactor.hpp"
+#include "npipe/StopToken.hpp"
+#include "npipe/TimeoutException.hpp"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstddef>
+#include <exception>
+#include <thread>
+#include <vector>
+
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+#	include <coroutine>
+
+constexpr const char *coroutinePipeName = "coroutineTestPipe";
+
+static const std::vector< std::byte > coroutineMessage = { std::byte(3), std::byte(1), std::byte(4), std::byte(1),
+														   std::byte(5), std::byte(9) };
+
+/**
+ * Minimal coroutine type that starts right away and cleans up after itself
+ */
+struct Task {
+	struct promise_type {
+		Task get_return_object() noexcept { return {}; }
+		std::suspend_never initial_suspend() noexcept { return {}; }
+		std::suspend_never final_suspend() noexcept { return {}; }
+		void return_void() noexcept {}
+		void unhandled_exception() noexcept { std::terminate(); }
+	};
+};
+
+Task readOnce(const npipe::NamedPipe &pipe, npipe::Reactor &reactor, std::vector< std::byte > &received) {
+	received = co_await pipe.async_read(reactor, std::chrono::seconds(5));
+
+	reactor.stop();
+}
+
+Task writeOnce(npipe::PipeWriter &writer, npipe::Reactor &reactor) {
+	co_await writer.async_write(reactor, coroutineMessage.data(), coroutineMessage.size(), std::chrono::seconds(5));
+}
+
+Task readFailing(const npipe::NamedPipe &pipe, npipe::Reactor &reactor, std::chrono::milliseconds timeout,
+				 npipe::StopToken stopToken, bool &timedOut, bool &interrupted) {
+	try {
+		co_await pipe.async_read(reactor, timeout, stopToken);
+	} catch (const npipe::TimeoutException &) {
+		timedOut = true;
+	} catch (const npipe::InterruptException &) {
+		interrupted = true;
+	}
+
+	reactor.stop();
+}
+
+TEST(Coroutine, read_write) {
+	npipe::NamedPipe pipe = npipe::NamedPipe::create(coroutinePipeName);
+	npipe::PipeWriter writer(coroutinePipeName);
+	npipe::Reactor reactor;
+
+	std::vector< std::byte > received;
+
+	// Both coroutines are served by the thread running the reactor
+	readOnce(pipe, reactor, received);
+	writeOnce(writer, reactor);
+
+	reactor.run();
+
+	ASSERT_EQ(received, coroutineMessage);
+}
+
+TEST(Coroutine, write_waits_for_reader) {
+	npipe::PipeWriter writer(coroutinePipeName);
+	npipe::Reactor reactor;
+
+	writeOnce(writer, reactor);
+
+	std::thread reactorThread([&]() { reactor.run(); });
+
+	std::this_thread::sleep_for(std::chrono::milliseconds(20));
+	npipe::NamedPipe pipe = npipe::NamedPipe::create(coroutinePipeName);
+
+	ASSERT_EQ(pipe.read_blocking(std::chrono::seconds(5)), coroutineMessage);
+
+	reactor.stop();
+	reactorThread.join();
+}
+
+TEST(Coroutine, read_timeout) {
+	npipe::NamedPipe pipe = npipe::NamedPipe::create(coroutinePipeName);
+	npipe::Reactor reactor;
+
+	bool timedOut    = false;
+	bool interrupted = false;
+	readFailing(pipe, reactor, std::chrono::milliseconds(20), npipe::StopToken(), timedOut, interrupted);
+
+	reactor.run();
+
+	ASSERT_TRUE(timedOut);
+	ASSERT_FALSE(interrupted);
+}
+
+TEST(Coroutine, read_cancel) {
+	npipe::NamedPipe pipe = npipe::NamedPipe::create(coroutinePipeName);
+	npipe::Reactor reactor;
+	npipe::StopSource stopSource;
+
+	bool timedOut    = false;
+	bool interrupted = false;
+	readFailing(pipe, reactor, std::chrono::seconds(5), stopSource.get_token(), timedOut, interrupted);
+
+	std::thread reactorThread([&]() { reactor.run(); });
+
+	stopSource.request_stop();
+
+	reactorThread.join();
+
+	ASSERT_FALSE(timedOut);
+	ASSERT_TRUE(interrupted);
+}
+
+#endif
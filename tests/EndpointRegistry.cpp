@@ -0,0 +1,135 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// source tree or at
+// <https://github.com/Krzmbrzl/NamedPipe/blob/main/LICENSE>.
+
+#include "npipe/EndpointRegistry.hpp"
+#include "npipe/EndpointUnavailableException.hpp"
+#include "npipe/NamedPipe.hpp"
+#include "npipe/TimeoutException.hpp"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstddef>
+#include <filesystem>
+#include <thread>
+#include <vector>
+
+constexpr const char *registryPipeName = "registryTestPipe";
+
+static const std::vector< std::byte > registryMessage = { std::byte(7), std::byte(11), std::byte(13) };
+
+TEST(EndpointRegistry, fail_fast) {
+	npipe::EndpointRegistryOptions options;
+	options.coolDown = std::chrono::seconds(10);
+
+	npipe::EndpointRegistry registry(options);
+
+	ASSERT_TRUE(registry.isAvailable(registryPipeName));
+
+	// The first write has to find out that there is no reader the hard way
+	ASSERT_THROW(registry.write(registryPipeName, registryMessage.data(), registryMessage.size(),
+								std::chrono::milliseconds(100)),
+				 npipe::TimeoutException);
+	ASSERT_FALSE(registry.isAvailable(registryPipeName));
+
+	// Subsequent writes don't wait anymore
+	const auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < 100; ++i) {
+		ASSERT_THROW(registry.write(registryPipeName, registryMessage.data(), registryMessage.size(),
+									std::chrono::milliseconds(100)),
+					 npipe::EndpointUnavailableException);
+	}
+	ASSERT_LT(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(100));
+}
+
+TEST(EndpointRegistry, recover) {
+	npipe::EndpointRegistryOptions options;
+	options.coolDown      = std::chrono::seconds(10);
+	options.probeInterval = std::chrono::seconds(10);
+
+	npipe::EndpointRegistry registry(options);
+
+	ASSERT_THROW(registry.write_message(registryPipeName, registryMessage.data(), registryMessage.size(),
+										std::chrono::milliseconds(10)),
+				 npipe::TimeoutException);
+	ASSERT_FALSE(registry.isAvailable(registryPipeName));
+
+	npipe::NamedPipe pipe = npipe::NamedPipe::create(registryPipeName);
+
+	// The prober has to notice the reader long before the cool-down (or the probe interval, unless the pipe's
+	// creation can be observed) is over
+	const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+	while (!registry.isAvailable(registryPipeName) && std::chrono::steady_clock::now() < deadline) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	ASSERT_TRUE(registry.isAvailable(registryPipeName));
+
+	registry.write_message(registryPipeName, registryMessage.data(), registryMessage.size());
+	ASSERT_EQ(pipe.read_message(std::chrono::seconds(1)), registryMessage);
+}
+
+TEST(EndpointRegistry, evict_idle) {
+	npipe::EndpointRegistryOptions options;
+	options.coolDown      = std::chrono::seconds(10);
+	options.probeInterval = std::chrono::milliseconds(10);
+	options.evictAfter    = std::chrono::milliseconds(50);
+
+	npipe::EndpointRegistry registry(options);
+
+	ASSERT_THROW(registry.write(registryPipeName, registryMessage.data(), registryMessage.size(),
+								std::chrono::milliseconds(10)),
+				 npipe::TimeoutException);
+	ASSERT_FALSE(registry.isAvailable(registryPipeName));
+	ASSERT_EQ(registry.size(), 1);
+
+	const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+	while (registry.size() > 0 && std::chrono::steady_clock::now() < deadline) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	ASSERT_EQ(registry.size(), 0);
+
+	// A forgotten endpoint is given a fresh chance
+	ASSERT_TRUE(registry.isAvailable(registryPipeName));
+}
+
+TEST(EndpointRegistry, recover_in_replaced_directory) {
+	const std::filesystem::path directory = "registryTestDirectory";
+	const std::filesystem::path pipePath  = directory / registryPipeName;
+
+	std::filesystem::remove_all(directory);
+	std::filesystem::create_directory(directory);
+
+	npipe::EndpointRegistryOptions options;
+	options.coolDown      = std::chrono::seconds(10);
+	options.probeInterval = std::chrono::seconds(10);
+
+	npipe::EndpointRegistry registry(options);
+
+	ASSERT_THROW(registry.write_message(pipePath, registryMessage.data(), registryMessage.size(),
+										std::chrono::milliseconds(10)),
+				 npipe::TimeoutException);
+	ASSERT_FALSE(registry.isAvailable(pipePath));
+
+	// Replace the watched directory by a new one
+	const std::filesystem::path replacement = "registryTestReplacement";
+	std::filesystem::remove_all(replacement);
+	std::filesystem::create_directory(replacement);
+	std::filesystem::rename(replacement, directory);
+
+	// Give the prober the chance to notice and to watch the new directory
+	std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+	{
+		npipe::NamedPipe pipe = npipe::NamedPipe::create(pipePath);
+
+		const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+		while (!registry.isAvailable(pipePath) && std::chrono::steady_clock::now() < deadline) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		ASSERT_TRUE(registry.isAvailable(pipePath));
+	}
+
+	std::filesystem::remove_all(directory);
+}
@@ -0,0 +1,113 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// source tree or at
+// <https://github.com/Krzmbrzl/NamedPipe/blob/main/LICENSE>.
+
+#include "npipe/FanOut.hpp"
+#include "npipe/NamedPipe.hpp"
+#include "npipe/PipeWriter.hpp"
+#include "npipe/TimeoutException.hpp"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+constexpr const char *fanOutSourceName = "fanOutSourcePipe";
+constexpr const char *fanOutFirstName  = "fanOutFirstPipe";
+constexpr const char *fanOutSecondName = "fanOutSecondPipe";
+
+static std::vector< std::byte > receive(const npipe::NamedPipe &pipe, std::size_t size) {
+	std::vector< std::byte > received(size);
+	std::size_t receivedBytes = 0;
+
+	while (receivedBytes < size) {
+		receivedBytes +=
+			pipe.read_into(received.data() + receivedBytes, size - receivedBytes, std::chrono::seconds(5));
+	}
+
+	return received;
+}
+
+TEST(FanOut, duplicate) {
+	npipe::NamedPipe source = npipe::NamedPipe::create(fanOutSourceName);
+	npipe::NamedPipe first  = npipe::NamedPipe::create(fanOutFirstName);
+	npipe::NamedPipe second = npipe::NamedPipe::create(fanOutSecondName);
+
+	npipe::FanOut fanOut(source, { fanOutFirstName, fanOutSecondName });
+	ASSERT_EQ(fanOut.destinationCount(), 2);
+
+	// More than fits into the destinations at once, so that the backlogs come into play
+	std::vector< std::byte > content(256 * 1024);
+	for (std::size_t i = 0; i < content.size(); ++i) {
+		content[i] = static_cast< std::byte >(i % 249);
+	}
+
+	std::thread writeThread([&]() {
+		npipe::PipeWriter(fanOutSourceName).write(content.data(), content.size(), std::chrono::seconds(5));
+	});
+
+	std::vector< std::byte > firstReceived;
+	std::vector< std::byte > secondReceived;
+	std::thread firstThread([&]() { firstReceived = receive(first, content.size()); });
+	std::thread secondThread([&]() { secondReceived = receive(second, content.size()); });
+
+	std::size_t forwarded = 0;
+	while (forwarded < content.size()) {
+		forwarded += fanOut.forward(std::chrono::seconds(5));
+	}
+
+	// Hand over whatever is left in the backlogs
+	while (fanOut.backlogSize(0) > 0 || fanOut.backlogSize(1) > 0) {
+		ASSERT_THROW(fanOut.forward(std::chrono::milliseconds(10)), npipe::TimeoutException);
+	}
+
+	writeThread.join();
+	firstThread.join();
+	secondThread.join();
+
+	ASSERT_EQ(forwarded, content.size());
+	ASSERT_EQ(firstReceived, content);
+	ASSERT_EQ(secondReceived, content);
+}
+
+TEST(FanOut, drop_slow_consumer) {
+	npipe::NamedPipe source = npipe::NamedPipe::create(fanOutSourceName);
+	npipe::NamedPipe first  = npipe::NamedPipe::create(fanOutFirstName);
+	// Nobody ever reads from this one
+	npipe::NamedPipe second = npipe::NamedPipe::create(fanOutSecondName);
+
+	npipe::FanOutOptions options;
+	options.maxBacklog        = 256 * 1024;
+	options.dropSlowConsumers = true;
+
+	npipe::FanOut fanOut(source, { fanOutFirstName, fanOutSecondName }, options);
+
+	const std::vector< std::byte > content(2 * 1024 * 1024, std::byte(3));
+
+	std::thread writeThread([&]() {
+		npipe::PipeWriter(fanOutSourceName).write(content.data(), content.size(), std::chrono::seconds(5));
+	});
+
+	std::vector< std::byte > firstReceived;
+	std::thread firstThread([&]() { firstReceived = receive(first, content.size()); });
+
+	std::size_t forwarded = 0;
+	while (forwarded < content.size()) {
+		forwarded += fanOut.forward(std::chrono::seconds(5));
+	}
+
+	while (fanOut.backlogSize(0) > 0) {
+		ASSERT_THROW(fanOut.forward(std::chrono::milliseconds(10)), npipe::TimeoutException);
+	}
+
+	writeThread.join();
+	firstThread.join();
+
+	ASSERT_FALSE(fanOut.isDropped(0));
+	ASSERT_TRUE(fanOut.isDropped(1));
+	ASSERT_EQ(fanOut.backlogSize(1), 0);
+	ASSERT_EQ(firstReceived, content);
+}
@@ -0,0 +1,281 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// source tree or at
+// <https://github.com/Krzmbrzl/NamedPipe/blob/main/LICENSE>.
+
+#include "npipe/Framing.hpp"
+#include "npipe/FramingException.hpp"
+#include "npipe/NamedPipe.hpp"
+#include "npipe/PipeWriter.hpp"
+#include "npipe/TimeoutException.hpp"
+
+#include <gtest/gtest.h>
+
+#ifdef PIPE_PLATFORM_UNIX
+#	include <poll.h>
+#endif
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+constexpr const char *framingPipeName = "framingTestPipe";
+
+static std::vector< std::byte > makeMessage(std::size_t size, std::byte seed) {
+	std::vector< std::byte > message(size);
+	for (std::size_t i = 0; i < size; ++i) {
+		message[i] = std::byte(static_cast< unsigned char >(i)) ^ seed;
+	}
+
+	return message;
+}
+
+static std::vector< std::byte > makeFrame(const std::vector< std::byte > &payload) {
+	std::vector< std::byte > frame(npipe::FrameHeader::size);
+	npipe::FrameHeader{ 0, static_cast< std::uint32_t >(payload.size()) }.encode(frame.data());
+	frame.insert(frame.end(), payload.begin(), payload.end());
+
+	return frame;
+}
+
+TEST(FrameDecoder, byte_by_byte) {
+	const std::vector< std::byte > payload = makeMessage(100, std::byte(3));
+	const std::vector< std::byte > frame   = makeFrame(payload);
+
+	npipe::FrameDecoder decoder;
+	std::vector< std::byte > message;
+
+	for (std::size_t i = 0; i < frame.size(); ++i) {
+		ASSERT_FALSE(decoder.next(message));
+		decoder.feed(&frame[i], 1);
+	}
+
+	ASSERT_TRUE(decoder.next(message));
+	ASSERT_EQ(message, payload);
+	ASSERT_EQ(decoder.bufferedSize(), 0);
+}
+
+TEST(FrameDecoder, multiple_frames) {
+	const std::vector< std::byte > first  = makeMessage(10, std::byte(1));
+	const std::vector< std::byte > second = makeMessage(0, std::byte(2));
+	const std::vector< std::byte > third  = makeMessage(300, std::byte(3));
+
+	std::vector< std::byte > stream = makeFrame(first);
+	for (const std::vector< std::byte > &payload : { second, third }) {
+		const std::vector< std::byte > frame = makeFrame(payload);
+		stream.insert(stream.end(), frame.begin(), frame.end());
+	}
+
+	npipe::FrameDecoder decoder;
+	std::vector< std::byte > message;
+
+	// Feed everything but the last byte
+	decoder.feed(stream.data(), stream.size() - 1);
+
+	ASSERT_TRUE(decoder.next(message));
+	ASSERT_EQ(message, first);
+	ASSERT_TRUE(decoder.next(message));
+	ASSERT_EQ(message, second);
+	ASSERT_FALSE(decoder.next(message));
+
+	decoder.feed(&stream.back(), 1);
+
+	ASSERT_TRUE(decoder.next(message));
+	ASSERT_EQ(message, third);
+}
+
+TEST(FrameDecoder, invalid_header) {
+	const std::array< std::byte, npipe::FrameHeader::size > garbage = {};
+
+	npipe::FrameDecoder decoder;
+	decoder.feed(garbage.data(), garbage.size());
+
+	std::vector< std::byte > message;
+	ASSERT_THROW(decoder.next(message), npipe::FramingException);
+}
+
+TEST(FrameDecoder, recover_after_invalid_header) {
+	const std::vector< std::byte > payload = makeMessage(5, std::byte(9));
+
+	// Some garbage followed by a valid frame
+	std::vector< std::byte > stream      = { std::byte(1), std::byte(2), std::byte(3) };
+	const std::vector< std::byte > frame = makeFrame(payload);
+	stream.insert(stream.end(), frame.begin(), frame.end());
+
+	npipe::FrameDecoder decoder;
+	decoder.feed(stream.data(), stream.size());
+
+	std::vector< std::byte > message;
+	ASSERT_THROW(decoder.next(message), npipe::FramingException);
+
+	// The garbage has been dropped, so the valid frame can be read afterwards
+	ASSERT_TRUE(decoder.next(message));
+	ASSERT_EQ(message, payload);
+	ASSERT_EQ(decoder.bufferedSize(), 0);
+}
+
+TEST(FrameDecoder, oversized_frame) {
+	std::array< std::byte, npipe::FrameHeader::size > header;
+	npipe::FrameHeader{ 0, npipe::FrameHeader::maxLength + 1 }.encode(header.data());
+
+	npipe::FrameDecoder decoder;
+	decoder.feed(header.data(), header.size());
+
+	// Rather than waiting for the (bogus) payload to arrive, the header is rejected and discarded
+	std::vector< std::byte > message;
+	ASSERT_THROW(decoder.next(message), npipe::FramingException);
+	ASSERT_EQ(decoder.bufferedSize(), 0);
+}
+
+TEST(NamedPipe, framed_io) {
+	npipe::NamedPipe pipe = npipe::NamedPipe::create(framingPipeName);
+	npipe::PipeWriter writer(framingPipeName);
+
+	const std::vector< std::byte > small = makeMessage(7, std::byte(42));
+	const std::vector< std::byte > large = makeMessage(200 * 1024, std::byte(7));
+
+	// Write several messages back-to-back without waiting for the reader. The large one doesn't fit into the pipe
+	// at once, so writing has to happen concurrently to reading.
+	std::thread writeThread([&]() {
+		npipe::NamedPipe::write_message(framingPipeName, small.data(), small.size(), std::chrono::seconds(1));
+		writer.write_message(large.data(), large.size(), std::chrono::seconds(5));
+		writer.write_message(small.data(), small.size(), std::chrono::seconds(1));
+	});
+
+	ASSERT_EQ(pipe.read_message(std::chrono::seconds(5)), small);
+	ASSERT_EQ(pipe.read_message(std::chrono::seconds(5)), large);
+	ASSERT_EQ(pipe.read_message(std::chrono::seconds(5)), small);
+
+	writeThread.join();
+}
+
+TEST(NamedPipe, write_many) {
+	npipe::NamedPipe pipe = npipe::NamedPipe::create(framingPipeName);
+
+	// Enough messages to require several groups, including one that exceeds PIPE_BUF on its own
+	std::vector< std::vector< std::byte > > payloads;
+	for (std::size_t i = 0; i < 100; ++i) {
+		payloads.emplace_back(i % 17, static_cast< std::byte >(i));
+	}
+	payloads.emplace_back(64 * 1024, std::byte(42));
+	payloads.emplace_back();
+
+	std::vector< npipe::ConstBuffer > messages;
+	for (const std::vector< std::byte > &current : payloads) {
+		messages.push_back({ current.data(), current.size() });
+	}
+
+	std::size_t written = 0;
+	std::thread writeThread([&]() {
+		written =
+			npipe::NamedPipe::write_many(framingPipeName, messages.data(), messages.size(), std::chrono::seconds(5));
+	});
+
+	for (const std::vector< std::byte > &current : payloads) {
+		ASSERT_EQ(pipe.read_message(std::chrono::seconds(5)), current);
+	}
+
+	writeThread.join();
+	ASSERT_EQ(written, messages.size());
+}
+
+#ifdef PIPE_PLATFORM_UNIX
+TEST(NamedPipe, write_many_timeout_mid_frame) {
+	npipe::NamedPipe pipe = npipe::NamedPipe::create(framingPipeName);
+	npipe::PipeWriter writer(framingPipeName);
+
+	const std::vector< std::byte > small = makeMessage(7, std::byte(3));
+	// Way more than fits into the pipe, so that the timeout expires while the frame is being written
+	const std::vector< std::byte > large = makeMessage(256 * 1024, std::byte(5));
+
+	const std::array< npipe::ConstBuffer, 3 > messages = { { { small.data(), small.size() },
+															 { large.data(), large.size() },
+															 { small.data(), small.size() } } };
+
+	std::size_t written = 0;
+	std::thread writeThread(
+		[&]() { written = writer.write_many(messages.data(), messages.size(), std::chrono::milliseconds(50)); });
+
+	std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+	// The started frame has been finished despite the timeout
+	ASSERT_EQ(pipe.read_message(std::chrono::seconds(5)), small);
+	ASSERT_EQ(pipe.read_message(std::chrono::seconds(5)), large);
+
+	writeThread.join();
+	ASSERT_EQ(written, 2);
+
+	// Resending from the reported index continues the stream seamlessly
+	ASSERT_EQ(writer.write_many(messages.data() + written, messages.size() - written, std::chrono::seconds(1)), 1);
+	ASSERT_EQ(pipe.read_message(std::chrono::seconds(1)), small);
+}
+
+TEST(NamedPipe, write_message_timeout_mid_frame) {
+	npipe::NamedPipe pipe = npipe::NamedPipe::create(framingPipeName);
+	npipe::PipeWriter writer(framingPipeName);
+
+	const std::vector< std::byte > large = makeMessage(256 * 1024, std::byte(6));
+
+	std::thread writeThread([&]() { writer.write_message(large.data(), large.size(), std::chrono::milliseconds(50)); });
+
+	std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+	ASSERT_EQ(pipe.read_message(std::chrono::seconds(5)), large);
+
+	writeThread.join();
+}
+
+TEST(NamedPipe, write_message_stalled_reader) {
+	npipe::NamedPipe pipe = npipe::NamedPipe::create(framingPipeName);
+	npipe::PipeWriter writer(framingPipeName);
+	writer.setFrameGracePeriod(std::chrono::milliseconds(100));
+
+	const std::vector< std::byte > large = makeMessage(256 * 1024, std::byte(7));
+
+	// Nobody reads, so the frame can't be finished within the grace period either
+	const auto start = std::chrono::steady_clock::now();
+	ASSERT_THROW(writer.write_message(large.data(), large.size(), std::chrono::milliseconds(50)),
+				 npipe::TimeoutException);
+	ASSERT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(1));
+
+	// The torn frame must not be followed by further frames
+	ASSERT_FALSE(writer.isConnected());
+}
+
+TEST(NamedPipe, read_available) {
+	npipe::NamedPipe pipe = npipe::NamedPipe::create(framingPipeName);
+	npipe::PipeWriter writer(framingPipeName);
+
+	npipe::MessageBatch batch;
+
+	// Nothing there yet, but reading must not block
+	ASSERT_EQ(pipe.read_available(batch), 0);
+
+	const std::vector< std::byte > first  = makeFrame(makeMessage(10, std::byte(1)));
+	const std::vector< std::byte > second = makeFrame(makeMessage(20, std::byte(2)));
+
+	// One complete frame followed by the first half of another one
+	std::vector< std::byte > content = first;
+	content.insert(content.end(), second.begin(), second.begin() + 12);
+	writer.write(content.data(), content.size(), std::chrono::seconds(1));
+
+	pollfd pollData = { pipe.native_handle(), POLLIN, 0 };
+	ASSERT_EQ(::poll(&pollData, 1, 1000), 1);
+
+	ASSERT_EQ(pipe.read_available(batch), 1);
+	ASSERT_EQ(std::vector< std::byte >(batch[0].data, batch[0].data + batch[0].size), makeMessage(10, std::byte(1)));
+
+	// The partial frame has been consumed from the pipe and is kept until the rest of it arrives
+	ASSERT_EQ(::poll(&pollData, 1, 0), 0);
+	ASSERT_EQ(pipe.read_available(batch), 0);
+
+	writer.write(second.data() + 12, second.size() - 12, std::chrono::seconds(1));
+	ASSERT_EQ(::poll(&pollData, 1, 1000), 1);
+
+	ASSERT_EQ(pipe.read_available(batch), 1);
+	ASSERT_EQ(std::vector< std::byte >(batch[0].data, batch[0].data + batch[0].size), makeMessage(20, std::byte(2)));
+}
+#endif
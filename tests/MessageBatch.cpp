@@ -0,0 +1,79 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// source tree or at
+// <https://github.com/Krzmbrzl/NamedPipe/blob/main/LICENSE>.
+
+#include "npipe/MessageBatch.hpp"
+#include "npipe/NamedPipe.hpp"
+#include "npipe/TimeoutException.hpp"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstddef>
+#include <vector>
+
+constexpr const char *batchPipeName = "batchTestPipe";
+
+static std::vector< std::byte > toVector(const npipe::ConstBuffer &buffer) {
+	return std::vector< std::byte >(buffer.data, buffer.data + buffer.size);
+}
+
+TEST(MessageBatch, append) {
+	npipe::MessageBatch batch;
+	ASSERT_TRUE(batch.empty());
+
+	const std::vector< std::byte > first  = { std::byte(1), std::byte(2), std::byte(3) };
+	const std::vector< std::byte > second = { std::byte(4) };
+
+	batch.append(first.data(), first.size());
+	batch.append(nullptr, 0);
+	batch.append(second.data(), second.size());
+
+	ASSERT_EQ(batch.size(), 3);
+	ASSERT_EQ(batch.byteSize(), first.size() + second.size());
+	ASSERT_EQ(toVector(batch[0]), first);
+	ASSERT_EQ(batch[1].size, 0);
+	ASSERT_EQ(toVector(batch[2]), second);
+
+	// The payloads are stored back-to-back
+	ASSERT_EQ(batch[2].data, batch.data() + first.size());
+
+	std::size_t count = 0;
+	for (const npipe::ConstBuffer &current : batch) {
+		ASSERT_EQ(current.data, batch[count].data);
+		++count;
+	}
+	ASSERT_EQ(count, batch.size());
+
+	batch.clear();
+	ASSERT_TRUE(batch.empty());
+	ASSERT_EQ(batch.byteSize(), 0);
+}
+
+TEST(NamedPipe, read_batch) {
+	npipe::NamedPipe pipe = npipe::NamedPipe::create(batchPipeName);
+
+	std::vector< std::vector< std::byte > > payloads;
+	std::vector< npipe::ConstBuffer > messages;
+	for (std::size_t i = 0; i < 200; ++i) {
+		payloads.emplace_back(i % 13, static_cast< std::byte >(i));
+	}
+	for (const std::vector< std::byte > &current : payloads) {
+		messages.push_back({ current.data(), current.size() });
+	}
+
+	ASSERT_EQ(npipe::NamedPipe::write_many(batchPipeName, messages.data(), messages.size(), std::chrono::seconds(1)),
+			  messages.size());
+
+	// Everything fits into the pipe at once, so a single read has to yield all messages
+	npipe::MessageBatch batch;
+	ASSERT_EQ(pipe.read_batch(batch, std::chrono::seconds(1)), payloads.size());
+
+	for (std::size_t i = 0; i < payloads.size(); ++i) {
+		ASSERT_EQ(toVector(batch[i]), payloads[i]);
+	}
+
+	ASSERT_THROW(pipe.read_batch(batch, std::chrono::milliseconds(100)), npipe::TimeoutException);
+	ASSERT_TRUE(batch.empty());
+}
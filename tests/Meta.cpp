@@ -6,10 +6,13 @@
 #include "npipe/Exception.hpp"
 #include "npipe/InterruptException.hpp"
 #include "npipe/NamedPipe.hpp"
+#include "npipe/StopToken.hpp"
 #include "npipe/TimeoutException.hpp"
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <array>
 #include <atomic>
 #include <chrono>
 #include <condition_variable>
@@ -115,3 +118,102 @@ TEST(NamedPipe, interrupt) {
 
 	thread.join();
 }
+
+TEST(NamedPipe, write_without_active_read) {
+	npipe::NamedPipe pipe = npipe::NamedPipe::create(metaPipeName);
+
+	// The pipe is kept open for reading, so writing must succeed even though no read is currently in progress
+	npipe::NamedPipe::write(metaPipeName, sampleMessage.data(), sampleMessage.size(), std::chrono::milliseconds(10));
+	npipe::NamedPipe::write(metaPipeName, sampleMessage.data(), sampleMessage.size(), std::chrono::milliseconds(10));
+
+	std::vector< std::byte > expected = sampleMessage;
+	expected.insert(expected.end(), sampleMessage.begin(), sampleMessage.end());
+
+	ASSERT_EQ(pipe.read_blocking(std::chrono::seconds(1)), expected);
+
+	// All writers are gone, but this must not be reported as EOF
+	std::vector< std::byte > dummy;
+	ASSERT_THROW(dummy = pipe.read_blocking(std::chrono::milliseconds(100)), npipe::TimeoutException);
+}
+
+TEST(NamedPipe, stop_token) {
+	npipe::NamedPipe pipe = npipe::NamedPipe::create(metaPipeName);
+	npipe::StopSource stopSource;
+
+	std::thread thread([&]() {
+		std::vector< std::byte > dummy;
+		ASSERT_THROW(dummy = pipe.read_blocking(std::chrono::seconds(5), stopSource.get_token()),
+					 npipe::InterruptException);
+	});
+
+	// Wait a bit to ensure the read operation has started
+	std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+	const auto start = std::chrono::steady_clock::now();
+	ASSERT_TRUE(stopSource.request_stop());
+	thread.join();
+
+	ASSERT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(1));
+
+	// Stopping an individual read must not affect the pipe itself
+	npipe::NamedPipe::write(metaPipeName, sampleMessage.data(), sampleMessage.size(), std::chrono::seconds(1));
+	ASSERT_EQ(pipe.read_blocking(std::chrono::seconds(1)), sampleMessage);
+}
+
+TEST(NamedPipe, read_into) {
+	npipe::NamedPipe pipe = npipe::NamedPipe::create(metaPipeName);
+
+	npipe::NamedPipe::write(metaPipeName, sampleMessage.data(), sampleMessage.size(), std::chrono::seconds(1));
+
+	// Content that doesn't fit into the buffer has to remain available for the next read
+	std::vector< std::byte > buffer(4);
+	ASSERT_EQ(pipe.read_into(buffer.data(), buffer.size(), std::chrono::seconds(1)), 4);
+	ASSERT_EQ(buffer, std::vector< std::byte >(sampleMessage.begin(), sampleMessage.begin() + 4));
+
+	ASSERT_EQ(pipe.read_into(buffer.data(), buffer.size(), std::chrono::seconds(1)), sampleMessage.size() - 4);
+	ASSERT_TRUE(std::equal(sampleMessage.begin() + 4, sampleMessage.end(), buffer.begin()));
+
+	ASSERT_THROW(pipe.read_into(buffer.data(), buffer.size(), std::chrono::milliseconds(100)),
+				 npipe::TimeoutException);
+}
+
+TEST(NamedPipe, try_read) {
+	npipe::NamedPipe pipe = npipe::NamedPipe::create(metaPipeName);
+
+	std::vector< std::byte > buffer(sampleMessage.size());
+
+	npipe::Result< std::size_t > result = pipe.try_read(buffer.data(), buffer.size(), std::chrono::milliseconds(100));
+	ASSERT_EQ(result.status(), npipe::Status::Timeout);
+	ASSERT_EQ(result.value(), 0);
+
+	ASSERT_TRUE(npipe::NamedPipe::try_write(metaPipeName, sampleMessage.data(), sampleMessage.size(),
+											std::chrono::seconds(1)));
+
+	result = pipe.try_read(buffer.data(), buffer.size(), std::chrono::seconds(1));
+	ASSERT_TRUE(result.ok());
+	ASSERT_EQ(result.value(), sampleMessage.size());
+	ASSERT_EQ(buffer, sampleMessage);
+
+	pipe.interrupt();
+	ASSERT_EQ(pipe.try_read(buffer.data(), buffer.size()).status(), npipe::Status::Interrupted);
+
+	pipe.destroy();
+	ASSERT_EQ(pipe.try_read(buffer.data(), buffer.size()).status(), npipe::Status::Closed);
+}
+
+#ifdef __cpp_lib_memory_resource
+TEST(NamedPipe, pmr_read) {
+	npipe::NamedPipe pipe = npipe::NamedPipe::create(metaPipeName);
+
+	npipe::NamedPipe::write(metaPipeName, sampleMessage.data(), sampleMessage.size(), std::chrono::seconds(1));
+
+	// Any allocation not served by the arena would end up at the null resource and throw
+	std::array< std::byte, 1024 > arena;
+	std::pmr::monotonic_buffer_resource resource(arena.data(), arena.size(), std::pmr::null_memory_resource());
+
+	std::pmr::vector< std::byte > message = pipe.read_blocking(&resource, std::chrono::seconds(1));
+
+	ASSERT_TRUE(std::equal(message.begin(), message.end(), sampleMessage.begin(), sampleMessage.end()));
+	ASSERT_EQ(message.get_allocator().resource(), &resource);
+}
+#endif
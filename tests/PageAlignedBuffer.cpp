@@ -0,0 +1,64 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// source tree or at
+// <https://github.com/Krzmbrzl/NamedPipe/blob/main/LICENSE>.
+
+#include "npipe/NamedPipe.hpp"
+#include "npipe/PageAlignedBuffer.hpp"
+#include "npipe/PipeWriter.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <utility>
+#include <vector>
+
+constexpr const char *zeroCopyPipeName = "zeroCopyTestPipe";
+
+TEST(PageAlignedBuffer, alignment) {
+	const std::size_t pageSize = npipe::PageAlignedBuffer::pageSize();
+
+	npipe::PageAlignedBuffer buffer(pageSize + 1);
+	ASSERT_EQ(buffer.size(), pageSize + 1);
+	ASSERT_EQ(buffer.capacity(), 2 * pageSize);
+	ASSERT_EQ(reinterpret_cast< std::uintptr_t >(buffer.data()) % pageSize, 0);
+	ASSERT_TRUE(std::all_of(buffer.begin(), buffer.end(), [](std::byte current) { return current == std::byte(0); }));
+
+	const std::byte *data            = buffer.data();
+	npipe::PageAlignedBuffer moved = std::move(buffer);
+	ASSERT_EQ(moved.data(), data);
+	ASSERT_TRUE(buffer.empty());
+}
+
+TEST(PipeWriter, write_zero_copy) {
+	npipe::NamedPipe pipe = npipe::NamedPipe::create(zeroCopyPipeName);
+
+	// Exceeds the pipe's capacity, so that the writer has to wait for the reader in between
+	constexpr std::size_t size = 1024 * 1024 + 17;
+
+	npipe::PageAlignedBuffer buffer(size);
+	std::vector< std::byte > expected(size);
+	for (std::size_t i = 0; i < size; ++i) {
+		expected[i] = buffer.data()[i] = static_cast< std::byte >(i % 251);
+	}
+
+	std::vector< std::byte > received(size);
+	std::size_t receivedBytes = 0;
+	std::thread readThread([&]() {
+		while (receivedBytes < size) {
+			receivedBytes +=
+				pipe.read_into(received.data() + receivedBytes, size - receivedBytes, std::chrono::seconds(5));
+		}
+	});
+
+	npipe::PipeWriter writer(zeroCopyPipeName);
+	writer.write_zero_copy(std::move(buffer), std::chrono::seconds(5));
+
+	readThread.join();
+
+	ASSERT_EQ(received, expected);
+}
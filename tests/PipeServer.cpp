@@ -0,0 +1,144 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// source tree or at
+// <https://github.com/Krzmbrzl/NamedPipe/blob/main/LICENSE>.
+
+#include "npipe/NamedPipe.hpp"
+#include "npipe/PipeServer.hpp"
+#include "npipe/PipeWriter.hpp"
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+constexpr const char *pipeServerName = "pipeServerPipe";
+
+struct Sample {
+	std::uint32_t key;
+	std::uint32_t sequence;
+};
+
+static Sample decode(const std::vector< std::byte > &message) {
+	Sample sample{};
+	std::memcpy(&sample, message.data(), sizeof(sample));
+
+	return sample;
+}
+
+static void send(npipe::PipeWriter &writer, Sample sample) {
+	std::array< std::byte, sizeof(Sample) > message;
+	std::memcpy(message.data(), &sample, sizeof(sample));
+
+	writer.write_message(message.data(), message.size(), std::chrono::seconds(5));
+}
+
+TEST(PipeServer, dispatch_all) {
+	npipe::NamedPipe pipe = npipe::NamedPipe::create(pipeServerName);
+
+	constexpr std::uint32_t messageCount = 1000;
+	std::atomic_uint32_t handled         = 0;
+	std::atomic_uint64_t sequenceSum     = 0;
+
+	npipe::PipeServer server(
+		pipe,
+		[&](std::vector< std::byte > message) {
+			sequenceSum += decode(message).sequence;
+			++handled;
+		},
+		{}, npipe::PipeServerOptions{ 4 });
+	ASSERT_EQ(server.threadCount(), 4);
+
+	npipe::PipeWriter writer(pipeServerName);
+	for (std::uint32_t i = 0; i < messageCount; ++i) {
+		send(writer, { 0, i });
+	}
+
+	for (int i = 0; i < 500 && handled.load() < messageCount; ++i) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+
+	ASSERT_NO_THROW(server.stop());
+	ASSERT_EQ(handled.load(), messageCount);
+	ASSERT_EQ(sequenceSum.load(), std::uint64_t{ messageCount } * (messageCount - 1) / 2);
+}
+
+TEST(PipeServer, per_key_ordering) {
+	npipe::NamedPipe pipe = npipe::NamedPipe::create(pipeServerName);
+
+	constexpr std::uint32_t keyCount       = 8;
+	constexpr std::uint32_t messagesPerKey = 200;
+
+	std::mutex mutex;
+	std::vector< std::uint32_t > nextSequence(keyCount, 0);
+	std::atomic_uint32_t outOfOrder = 0;
+	std::atomic_uint32_t handled    = 0;
+
+	npipe::PipeServer server(
+		pipe,
+		[&](std::vector< std::byte > message) {
+			const Sample sample = decode(message);
+
+			// Give other workers the chance to (wrongly) pick up the key's next message in the meantime
+			std::this_thread::yield();
+
+			std::lock_guard< std::mutex > guard(mutex);
+			if (nextSequence[sample.key] != sample.sequence) {
+				++outOfOrder;
+			}
+			nextSequence[sample.key] = sample.sequence + 1;
+			++handled;
+		},
+		[](const std::vector< std::byte > &message) -> std::optional< std::uint64_t > { return decode(message).key; },
+		npipe::PipeServerOptions{ 4 });
+
+	npipe::PipeWriter writer(pipeServerName);
+	for (std::uint32_t sequence = 0; sequence < messagesPerKey; ++sequence) {
+		for (std::uint32_t key = 0; key < keyCount; ++key) {
+			send(writer, { key, sequence });
+		}
+	}
+
+	for (int i = 0; i < 500 && handled.load() < keyCount * messagesPerKey; ++i) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+
+	ASSERT_NO_THROW(server.stop());
+	ASSERT_EQ(handled.load(), keyCount * messagesPerKey);
+	ASSERT_EQ(outOfOrder.load(), 0);
+}
+
+TEST(PipeServer, stop_with_pending_strand) {
+	npipe::NamedPipe pipe = npipe::NamedPipe::create(pipeServerName);
+
+	constexpr std::uint32_t messageCount = 20;
+	std::atomic_uint32_t handled         = 0;
+
+	npipe::PipeServer server(
+		pipe,
+		[&](std::vector< std::byte >) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(20));
+			++handled;
+		},
+		[](const std::vector< std::byte > &) -> std::optional< std::uint64_t > { return 0; },
+		npipe::PipeServerOptions{ 2 });
+
+	npipe::PipeWriter writer(pipeServerName);
+	for (std::uint32_t i = 0; i < messageCount; ++i) {
+		send(writer, { 0, i });
+	}
+
+	// Stop while most of the strand's messages are still waiting to be handled
+	std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+	ASSERT_NO_THROW(server.stop());
+	ASSERT_EQ(handled.load(), messageCount);
+}
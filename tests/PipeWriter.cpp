@@ -0,0 +1,225 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// source tree or at
+// <https://github.com/Krzmbrzl/NamedPipe/blob/main/LICENSE>.
+
+#include "npipe/NamedPipe.hpp"
+#include "npipe/PipeWriter.hpp"
+#include "npipe/TimeoutException.hpp"
+
+#include <gtest/gtest.h>
+
+#ifdef PIPE_PLATFORM_UNIX
+#	include <fcntl.h>
+#	include <sys/stat.h>
+#	include <unistd.h>
+#endif
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+constexpr const char *writerPipeName = "writerTestPipe";
+
+static const std::vector< std::byte > writerMessage = { std::byte(4), std::byte(8), std::byte(15), std::byte(16),
+														std::byte(23), std::byte(42) };
+
+static std::vector< std::byte > sendAndReceive(npipe::PipeWriter &writer) {
+	npipe::NamedPipe pipe = npipe::NamedPipe::create(writerPipeName);
+
+	std::vector< std::byte > received;
+	std::thread readThread([&]() { received = pipe.read_blocking(std::chrono::seconds(5)); });
+
+	writer.write(writerMessage.data(), writerMessage.size(), std::chrono::seconds(5));
+
+	readThread.join();
+
+	return received;
+}
+
+TEST(PipeWriter, write) {
+	npipe::PipeWriter writer(writerPipeName);
+
+	ASSERT_FALSE(writer.isConnected());
+
+	ASSERT_EQ(sendAndReceive(writer), writerMessage);
+
+	ASSERT_TRUE(writer.isConnected());
+}
+
+TEST(PipeWriter, reconnect) {
+	npipe::PipeWriter writer(writerPipeName);
+
+	ASSERT_EQ(sendAndReceive(writer), writerMessage);
+
+	// The previous pipe has been destroyed in the meantime, so the writer has to notice the broken connection
+	// (without being killed by SIGPIPE) and connect to the new pipe instead
+	ASSERT_EQ(sendAndReceive(writer), writerMessage);
+}
+
+TEST(PipeWriter, write_timeout) {
+	npipe::PipeWriter writer(writerPipeName);
+
+	ASSERT_THROW(writer.write(writerMessage.data(), writerMessage.size(), std::chrono::milliseconds(500)),
+				 npipe::TimeoutException);
+	ASSERT_FALSE(writer.isConnected());
+}
+
+TEST(PipeWriter, wait_for_pipe) {
+	npipe::PipeWriter writer(writerPipeName);
+
+	// The writer starts waiting before the pipe exists and has to connect once it shows up
+	std::thread writeThread(
+		[&]() { writer.write(writerMessage.data(), writerMessage.size(), std::chrono::seconds(5)); });
+
+	std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+	npipe::NamedPipe pipe = npipe::NamedPipe::create(writerPipeName);
+
+	ASSERT_EQ(pipe.read_blocking(std::chrono::seconds(1)), writerMessage);
+
+	writeThread.join();
+
+	// Only the pipe itself is left behind in the directory (no temporary setup entries)
+	std::size_t entryCount = 0;
+	for (const std::filesystem::directory_entry &entry : std::filesystem::directory_iterator(".")) {
+		if (entry.path().filename().string().find(writerPipeName) != std::string::npos) {
+			++entryCount;
+		}
+	}
+	ASSERT_EQ(entryCount, 1);
+}
+
+#ifdef PIPE_PLATFORM_UNIX
+TEST(PipeWriter, blocking_reader) {
+	constexpr const char *fifoName = "blockingReaderPipe";
+	ASSERT_EQ(::mkfifo(fifoName, 0600), 0);
+
+	// The writer starts waiting before there is any reader
+	bool failed = false;
+	std::chrono::steady_clock::duration elapsed{};
+	std::thread writeThread([&]() {
+		const auto start = std::chrono::steady_clock::now();
+		try {
+			npipe::PipeWriter(fifoName).write(writerMessage.data(), writerMessage.size(), std::chrono::seconds(2));
+		} catch (const npipe::TimeoutException &) {
+			failed = true;
+		}
+		elapsed = std::chrono::steady_clock::now() - start;
+
+		// Should the write have failed, the reader would still be stuck in open()
+		const int unblockHandle = ::open(fifoName, O_WRONLY | O_NONBLOCK);
+		if (unblockHandle != -1) {
+			::close(unblockHandle);
+		}
+	});
+
+	std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+	// A reader that isn't built on NamedPipe and thus opens the pipe with a plain (blocking) open(), which only
+	// returns once a writer has connected
+	const int handle = ::open(fifoName, O_RDONLY);
+	ASSERT_NE(handle, -1);
+
+	std::vector< std::byte > received(writerMessage.size());
+	std::size_t receivedBytes = 0;
+	while (receivedBytes < received.size()) {
+		const ssize_t result = ::read(handle, received.data() + receivedBytes, received.size() - receivedBytes);
+		if (result <= 0) {
+			break;
+		}
+
+		receivedBytes += static_cast< std::size_t >(result);
+	}
+
+	::close(handle);
+	writeThread.join();
+	::unlink(fifoName);
+
+	ASSERT_FALSE(failed);
+	ASSERT_EQ(received, writerMessage);
+	ASSERT_LT(elapsed, std::chrono::milliseconds(500));
+}
+#endif
+
+TEST(PipeWriter, try_write) {
+	npipe::PipeWriter writer(writerPipeName);
+
+	// Without a reader, there is nothing to connect to
+	const npipe::Result< std::size_t > result =
+		writer.try_write(writerMessage.data(), writerMessage.size(), std::chrono::milliseconds(100));
+	ASSERT_EQ(result.status(), npipe::Status::Closed);
+	ASSERT_EQ(result.value(), 0);
+	ASSERT_FALSE(writer.isConnected());
+
+	npipe::NamedPipe pipe = npipe::NamedPipe::create(writerPipeName);
+
+	ASSERT_TRUE(writer.try_write(writerMessage.data(), writerMessage.size(), std::chrono::seconds(1)));
+	ASSERT_EQ(pipe.read_blocking(std::chrono::seconds(1)), writerMessage);
+}
+
+TEST(PipeWriter, write_gather) {
+	npipe::NamedPipe pipe = npipe::NamedPipe::create(writerPipeName);
+	npipe::PipeWriter writer(writerPipeName);
+
+	const std::vector< std::byte > header  = { std::byte(0xAA), std::byte(0xBB) };
+	const std::vector< std::byte > trailer = { std::byte(0xCC) };
+
+	const std::array< npipe::ConstBuffer, 3 > buffers = {
+		{ { header.data(), header.size() },
+		  { writerMessage.data(), writerMessage.size() },
+		  { trailer.data(), trailer.size() } }
+	};
+
+	writer.write_gather(buffers.data(), buffers.size(), std::chrono::seconds(1));
+
+	std::vector< std::byte > expected = header;
+	expected.insert(expected.end(), writerMessage.begin(), writerMessage.end());
+	expected.insert(expected.end(), trailer.begin(), trailer.end());
+
+	ASSERT_EQ(pipe.read_blocking(std::chrono::seconds(1)), expected);
+
+	// More segments than can be handled without allocating
+	const std::vector< npipe::ConstBuffer > segments(20, { writerMessage.data(), writerMessage.size() });
+	npipe::NamedPipe::write_gather(writerPipeName, segments.data(), segments.size(), std::chrono::seconds(1));
+
+	ASSERT_EQ(pipe.read_blocking(std::chrono::seconds(1)).size(), segments.size() * writerMessage.size());
+}
+
+TEST(PipeWriter, write_full_pipe) {
+	npipe::NamedPipe pipe = npipe::NamedPipe::create(writerPipeName);
+	npipe::PipeWriter writer(writerPipeName);
+
+	// This doesn't fit into the pipe at once, so the writer has to wait for the reader to make room
+	const std::vector< std::byte > message(1024 * 1024, std::byte(42));
+
+	std::thread writeThread([&]() { writer.write(message.data(), message.size(), std::chrono::seconds(5)); });
+
+	std::vector< std::byte > received;
+	while (received.size() < message.size()) {
+		std::vector< std::byte > content = pipe.read_blocking(std::chrono::seconds(5));
+		received.insert(received.end(), content.begin(), content.end());
+	}
+
+	writeThread.join();
+
+	ASSERT_EQ(received, message);
+}
+
+TEST(PipeWriter, write_partial) {
+	npipe::NamedPipe pipe = npipe::NamedPipe::create(writerPipeName);
+	npipe::PipeWriter writer(writerPipeName);
+
+	const std::vector< std::byte > message(1024 * 1024, std::byte(42));
+
+	// Nobody reads, so only a part of the message fits into the pipe
+	const std::size_t written = writer.write_partial(message.data(), message.size(), std::chrono::milliseconds(100));
+
+	ASSERT_GT(written, 0);
+	ASSERT_LT(written, message.size());
+	ASSERT_EQ(pipe.read_blocking(std::chrono::seconds(1)).size(), written);
+}
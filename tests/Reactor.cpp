@@ -0,0 +1,122 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// source tree or at
+// <https://github.com/Krzmbrzl/NamedPipe/blob/main/LICENSE>.
+
+#include "npipe/NamedPipe.hpp"
+#include "npipe/Reactor.hpp"
+#include "npipe/StopToken.hpp"
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef PIPE_PLATFORM_UNIX
+
+constexpr std::size_t reactorPipeCount = 8;
+
+static std::string reactorPipeName(std::size_t index) {
+	return "reactorTestPipe" + std::to_string(index);
+}
+
+TEST(Reactor, dispatch) {
+	std::vector< npipe::NamedPipe > pipes;
+	for (std::size_t i = 0; i < reactorPipeCount; ++i) {
+		pipes.push_back(npipe::NamedPipe::create(reactorPipeName(i)));
+	}
+
+	npipe::Reactor reactor;
+
+	std::array< std::vector< std::byte >, reactorPipeCount > received;
+	std::atomic_size_t receivedBytes = 0;
+
+	for (std::size_t i = 0; i < reactorPipeCount; ++i) {
+		reactor.add(pipes[i], [&, i](const npipe::NamedPipe &pipe) {
+			const std::vector< std::byte > content = pipe.read_blocking(std::chrono::milliseconds(0));
+
+			received[i].insert(received[i].end(), content.begin(), content.end());
+			receivedBytes += content.size();
+		});
+	}
+	ASSERT_EQ(reactor.size(), reactorPipeCount);
+
+	// A single thread serves all pipes
+	std::thread reactorThread([&]() { reactor.run(); });
+
+	for (std::size_t i = 0; i < reactorPipeCount; ++i) {
+		const std::byte content = static_cast< std::byte >(i);
+		npipe::NamedPipe::write(reactorPipeName(i), &content, 1, std::chrono::seconds(1));
+	}
+
+	const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+	while (receivedBytes.load() < reactorPipeCount && std::chrono::steady_clock::now() < deadline) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+
+	reactor.stop();
+	reactorThread.join();
+
+	for (std::size_t i = 0; i < reactorPipeCount; ++i) {
+		ASSERT_EQ(received[i], std::vector< std::byte >{ static_cast< std::byte >(i) });
+	}
+
+	// Once stopped, the reactor doesn't wait anymore
+	ASSERT_EQ(reactor.run_once(), 0);
+}
+
+TEST(Reactor, remove_from_callback) {
+	npipe::NamedPipe pipe = npipe::NamedPipe::create(reactorPipeName(0));
+
+	npipe::Reactor reactor;
+
+	std::size_t invocations = 0;
+	reactor.add(pipe, [&](const npipe::NamedPipe &readyPipe) {
+		++invocations;
+
+		// Leave the content in the pipe - without removing the pipe, the callback would be invoked again
+		reactor.remove(readyPipe);
+	});
+
+	const std::byte content = std::byte(42);
+	npipe::NamedPipe::write(reactorPipeName(0), &content, 1, std::chrono::seconds(1));
+
+	ASSERT_EQ(reactor.run_once(std::chrono::seconds(1)), 1);
+	ASSERT_EQ(reactor.size(), 0);
+	ASSERT_EQ(reactor.run_once(std::chrono::milliseconds(10)), 0);
+	ASSERT_EQ(invocations, 1);
+}
+
+TEST(Reactor, throwing_completion) {
+	npipe::Reactor reactor;
+
+	std::vector< npipe::Status > completed;
+	for (std::size_t i = 0; i < 2; ++i) {
+		reactor.watch(-1, 0, std::chrono::milliseconds(0), npipe::StopToken(), [&](npipe::Status status) {
+			completed.push_back(status);
+
+			if (completed.size() == 1) {
+				throw std::runtime_error("Completion failed");
+			}
+		});
+	}
+
+	std::this_thread::sleep_for(std::chrono::milliseconds(5));
+
+	ASSERT_THROW(reactor.run_once(std::chrono::seconds(1)), std::runtime_error);
+	ASSERT_EQ(completed.size(), 1);
+
+	// The completion that didn't get its turn isn't lost (and doesn't have to wait for any further events)
+	const auto start = std::chrono::steady_clock::now();
+	ASSERT_EQ(reactor.run_once(std::chrono::seconds(5)), 1);
+	ASSERT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(1));
+	ASSERT_EQ(completed, (std::vector< npipe::Status >{ npipe::Status::Timeout, npipe::Status::Timeout }));
+}
+
+#endif
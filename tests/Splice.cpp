@@ -0,0 +1,119 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// source tree or at
+// <https://github.com/Krzmbrzl/NamedPipe/blob/main/LICENSE>.
+
+#include "npipe/NamedPipe.hpp"
+#include "npipe/PipeWriter.hpp"
+#include "npipe/TimeoutException.hpp"
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+#ifdef PIPE_PLATFORM_UNIX
+#	include <fcntl.h>
+#	include <unistd.h>
+
+constexpr const char *splicePipeName = "spliceTestPipe";
+
+static const std::vector< std::byte > spliceMessage = { std::byte(1), std::byte(1), std::byte(2), std::byte(3),
+														std::byte(5), std::byte(8), std::byte(13), std::byte(21) };
+
+static std::vector< std::byte > readFile(int fd) {
+	std::vector< std::byte > content(1024);
+
+	const ssize_t size = ::pread(fd, content.data(), content.size(), 0);
+	content.resize(size > 0 ? static_cast< std::size_t >(size) : 0);
+
+	return content;
+}
+
+TEST(NamedPipe, relay_to_pipe) {
+	npipe::NamedPipe pipe = npipe::NamedPipe::create(splicePipeName);
+
+	std::array< int, 2 > destination;
+	ASSERT_EQ(::pipe(destination.data()), 0);
+
+	npipe::NamedPipe::write(splicePipeName, spliceMessage.data(), spliceMessage.size(), std::chrono::seconds(1));
+	npipe::NamedPipe::write(splicePipeName, spliceMessage.data(), spliceMessage.size(), std::chrono::seconds(1));
+
+	// Small chunks must not prevent everything available from being relayed
+	ASSERT_EQ(pipe.relay_to(destination[1], std::chrono::seconds(1), npipe::StopToken(), 3), 2 * spliceMessage.size());
+
+	std::vector< std::byte > expected = spliceMessage;
+	expected.insert(expected.end(), spliceMessage.begin(), spliceMessage.end());
+
+	std::vector< std::byte > received(2 * expected.size());
+	ASSERT_EQ(::read(destination[0], received.data(), received.size()), expected.size());
+	received.resize(expected.size());
+	ASSERT_EQ(received, expected);
+
+	ASSERT_THROW(pipe.relay_to(destination[1], std::chrono::milliseconds(100)), npipe::TimeoutException);
+
+	::close(destination[0]);
+	::close(destination[1]);
+}
+
+TEST(NamedPipe, relay_to_file) {
+	npipe::NamedPipe pipe = npipe::NamedPipe::create(splicePipeName);
+
+	std::array< char, 32 > fileName = { "spliceTestFileXXXXXX" };
+	const int file                  = ::mkstemp(fileName.data());
+	ASSERT_NE(file, -1);
+	::unlink(fileName.data());
+
+	npipe::NamedPipe::write(splicePipeName, spliceMessage.data(), spliceMessage.size(), std::chrono::seconds(1));
+
+	ASSERT_EQ(pipe.relay_to(file, std::chrono::seconds(1)), spliceMessage.size());
+	ASSERT_EQ(readFile(file), spliceMessage);
+
+	::close(file);
+}
+
+TEST(PipeWriter, write_file) {
+	npipe::NamedPipe pipe = npipe::NamedPipe::create(splicePipeName);
+
+	// Exceeds the pipe's capacity, so that writing has to be resumed once the reader made room
+	std::vector< std::byte > content(512 * 1024);
+	for (std::size_t i = 0; i < content.size(); ++i) {
+		content[i] = static_cast< std::byte >(i % 253);
+	}
+
+	std::array< char, 32 > fileName = { "spliceTestFileXXXXXX" };
+	const int file                  = ::mkstemp(fileName.data());
+	ASSERT_NE(file, -1);
+	ASSERT_EQ(::write(file, content.data(), content.size()), content.size());
+
+	constexpr std::size_t offset = 1000;
+	const std::vector< std::byte > expected(content.begin() + offset, content.end());
+
+	std::vector< std::byte > received(expected.size());
+	std::size_t receivedBytes = 0;
+	std::thread readThread([&]() {
+		while (receivedBytes < received.size()) {
+			receivedBytes += pipe.read_into(received.data() + receivedBytes, received.size() - receivedBytes,
+											std::chrono::seconds(5));
+		}
+	});
+
+	npipe::PipeWriter writer(splicePipeName);
+	// The range exceeds the end of the file
+	ASSERT_EQ(writer.write_file(fileName.data(), offset, content.size(), std::chrono::seconds(5)), expected.size());
+
+	readThread.join();
+	ASSERT_EQ(received, expected);
+
+	// Writing a sub-range via the descriptor
+	ASSERT_EQ(writer.write_file(file, 10, 5, std::chrono::seconds(1)), 5);
+	ASSERT_EQ(pipe.read_blocking(std::chrono::seconds(1)),
+			  std::vector< std::byte >(content.begin() + 10, content.begin() + 15));
+
+	::close(file);
+	::unlink(fileName.data());
+}
+#endif